@@ -0,0 +1,59 @@
+// Minimal timing helpers for the host benchmarks.
+
+#ifndef BENCH_HPP
+#define BENCH_HPP
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+namespace bench
+{
+    // Prevent the compiler from optimising away a computed value.
+    template <typename T>
+    inline void Consume(const T &value)
+    {
+        asm volatile("" : : "g"(&value) : "memory");
+    }
+
+    // Run fn() until at least min_seconds have elapsed; returns operations per second,
+    // where fn returns the number of operations it performed.
+    template <typename F>
+    double Throughput(F fn, double min_seconds = 0.5)
+    {
+        using clock = std::chrono::steady_clock;
+        long long ops = 0;
+        const auto start = clock::now();
+        double elapsed;
+        do
+        {
+            ops += fn();
+            elapsed = std::chrono::duration<double>(clock::now() - start).count();
+        } while (elapsed < min_seconds);
+        return ops / elapsed;
+    }
+
+    inline void Report(const char *name, const char *what, double per_second)
+    {
+        std::printf("%-32s %10.2f M%s/s\n", name, per_second / 1e6, what);
+    }
+
+    // The file of a stage, as methodconv.py names them with --per-stage-files.
+    inline std::string StageFilename(const std::string &directory, int stage)
+    {
+        static const char STAGE_CHARS[] = "?1234567890ETABCD";
+        return directory + "/methods-" + STAGE_CHARS[stage] + ".ccml";
+    }
+
+    // Open the method file of a stage: from the library.ccml which methodconv.py writes if the
+    // directory has one, otherwise from the stage's own file. False if there are no methods of the stage.
+    template <typename Reader>
+    bool OpenStage(Reader &reader, const std::string &directory, int stage)
+    {
+        if (reader.TryOpen((directory + "/library.ccml").c_str()) && reader.IsLibrary())
+            return reader.SelectStage(stage);
+        return reader.TryOpen(StageFilename(directory, stage).c_str());
+    }
+}
+
+#endif
@@ -0,0 +1,180 @@
+// Compares the throughput of comparing searches against titles: with the
+// generated switch ReadSearchChar used before the lookup tables, with the
+// tables, with the search normalised once, and against the normalised index
+// key of each title. Also checks the tables against the switch for every pair
+// of bytes, and that every way of comparing agrees. Titles are read from
+// library.ccml, or from the stage files if there is no library.
+// Usage: bench_charset [METHODS_DIR]
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+#include "bench.hpp"
+#include "../src/charset/charset.cpp"
+#include "../src/ringing/row.cpp"
+#include "../src/ringing/method.cpp"
+#include "../src/ringing/filereader.cpp"
+
+namespace charset
+{
+// Generated by `py -m prizmunicode.genhpp create_switch_hpp bench/gen_switch.hpp`
+#include "gen_switch.hpp"
+}
+
+// Index key width, as methodconv.py writes it.
+static const int KEY_WIDTH = 16;
+// Titles each search is compared against, around where it would be found.
+static const int NEIGHBOURS = 8;
+// Longest search typed.
+static const int MAX_QUERY_LENGTH = 20;
+
+static charset::CompareResult CompareSearchSwitch(const charset::NonMBChar *searchkey, const charset::MBChar *text)
+{
+    while (true)
+    {
+        charset::NonMBChar s = charset::ReadSearchCharSwitch(searchkey), t = charset::ReadSearchCharSwitch(text);
+        if (s == '\0')
+            return charset::Contained;
+        else if (t == '\0' || t < s)
+            return charset::BeforeKey;
+        else if (t > s)
+            return charset::AfterKey;
+    }
+}
+
+static int CheckTables()
+{
+    int mismatches = 0;
+    for (int a = 1; a < 0x100; a++)
+        for (int b = 0; b < 0x100; b++)
+        {
+            const charset::MBChar text[3] = {(charset::MBChar)a, (charset::MBChar)b, 0};
+            const charset::MBChar *s = text, *t = text;
+            if (charset::ReadSearchCharSwitch(s) != charset::ReadSearchChar(t))
+                mismatches++;
+        }
+    if (mismatches > 0)
+        std::printf("ReadSearchChar differs from the switch for %d pairs of bytes\n", mismatches);
+    return mismatches;
+}
+
+struct Query
+{
+    std::string text;       // as typed
+    std::string normalised; // padded with NUL to at least KEY_WIDTH
+    int length;
+};
+
+struct Title
+{
+    std::string text;
+    char key[KEY_WIDTH]; // as in the index: normalised, cut short and padded with NUL
+};
+
+struct Pair
+{
+    int query;
+    int title;
+};
+
+// Compare every pair in turn; returns the number of comparisons.
+template <typename F>
+static long long CompareAll(const std::vector<Pair> &pairs, F compare)
+{
+    for (const Pair &pair : pairs)
+        bench::Consume(compare(pair));
+    return pairs.size();
+}
+
+int main(int argc, char **argv)
+{
+    const std::string directory = argc > 1 ? argv[1] : "../methods";
+    int mismatches = CheckTables();
+
+    std::vector<Title> titles;
+    for (int stage = 2; stage <= ringing::MAX_BELLS; stage++)
+    {
+        ringing::MappedFileReader reader;
+        if (!bench::OpenStage(reader, directory, stage) || !reader.Search("", nullptr))
+            continue;
+        charset::MBChar title[ringing::MAX_METHOD_TITLE_LENGTH];
+        while (!reader.EndOfFile() && reader.ReadMethodSummary(nullptr, nullptr, title))
+        {
+            Title t = {title, {}};
+            charset::NonMBChar normalised[ringing::MAX_METHOD_TITLE_LENGTH + 1];
+            const int length = charset::NormaliseSearch(title, normalised, ringing::MAX_METHOD_TITLE_LENGTH);
+            memcpy(t.key, normalised, std::min(length, KEY_WIDTH));
+            titles.push_back(t);
+        }
+    }
+    if (titles.empty())
+    {
+        std::printf("No method files found in %s\n", directory.c_str());
+        return 1;
+    }
+
+    // search for the start of a title, and compare it with the titles around it
+    std::mt19937 random(25);
+    std::vector<Query> queries;
+    std::vector<Pair> pairs;
+    for (size_t i = 0; i < titles.size(); i += NEIGHBOURS)
+    {
+        const int at = random() % titles.size();
+        Query query;
+        query.text = titles[at].text.substr(0, 1 + random() % MAX_QUERY_LENGTH);
+        charset::NonMBChar normalised[ringing::MAX_METHOD_TITLE_LENGTH + 1];
+        query.length = charset::NormaliseSearch(query.text.c_str(), normalised, ringing::MAX_METHOD_TITLE_LENGTH);
+        query.normalised = std::string(normalised, query.length) + std::string(KEY_WIDTH, '\0');
+        for (int j = at - NEIGHBOURS / 2; j < at + NEIGHBOURS / 2; j++)
+            if (j >= 0 && j < (int)titles.size())
+                pairs.push_back({(int)queries.size(), j});
+        queries.push_back(query);
+    }
+
+    // as CompareIndexEntry: only read the title when the search is longer than the key
+    auto compare_key = [&](const Pair &pair)
+    {
+        const Query &query = queries[pair.query];
+        const Title &title = titles[pair.title];
+        charset::CompareResult result = charset::CompareSearchKey(
+            query.normalised.c_str(), query.length < KEY_WIDTH ? query.length : KEY_WIDTH, title.key);
+        if (result == charset::Contained && query.length > KEY_WIDTH)
+            result = charset::CompareNormalisedSearch(query.normalised.c_str(), title.text.c_str());
+        return result;
+    };
+
+    int contained = 0;
+    for (const Pair &pair : pairs)
+    {
+        const Query &query = queries[pair.query];
+        const char *title = titles[pair.title].text.c_str();
+        const charset::CompareResult result = CompareSearchSwitch(query.text.c_str(), title);
+        if (charset::CompareSearch(query.text.c_str(), title) != result ||
+            charset::CompareNormalisedSearch(query.normalised.c_str(), title) != result ||
+            compare_key(pair) != result)
+        {
+            if (mismatches < 10)
+                std::printf("comparisons of '%s' with '%s' differ\n", query.text.c_str(), title);
+            mismatches++;
+        }
+        contained += result == charset::Contained;
+    }
+    std::printf("%zu titles, %zu comparisons, %d of them matches\n", titles.size(), pairs.size(), contained);
+
+    auto report = [&](const char *name, auto compare)
+    {
+        bench::Report(name, "compares",
+                      bench::Throughput([&]
+                                        { return CompareAll(pairs, compare); }));
+    };
+    report("switch CompareSearch", [&](const Pair &pair)
+           { return CompareSearchSwitch(queries[pair.query].text.c_str(), titles[pair.title].text.c_str()); });
+    report("table CompareSearch", [&](const Pair &pair)
+           { return charset::CompareSearch(queries[pair.query].text.c_str(), titles[pair.title].text.c_str()); });
+    report("CompareNormalisedSearch", [&](const Pair &pair)
+           { return charset::CompareNormalisedSearch(queries[pair.query].normalised.c_str(),
+                                                     titles[pair.title].text.c_str()); });
+    report("CompareSearchKey", compare_key);
+    return mismatches == 0 ? 0 : 1;
+}
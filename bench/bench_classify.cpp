@@ -0,0 +1,104 @@
+// Classifies every method in the method library, spreading the stages
+// across threads. Usage: bench_classify [METHODS_DIR [THREADS]]
+
+#include <atomic>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+#include "bench.hpp"
+#include "../src/charset/charset.cpp"
+#include "../src/ringing/row.cpp"
+#include "../src/ringing/method.cpp"
+#include "../src/ringing/filereader.cpp"
+#include "../src/ringing/classify.cpp"
+
+static const char *CLASS_NAMES[] = {
+    "Principle", "Plain", "Treble Bob", "Surprise", "Delight", "Treble Place", "Alliance", "Hybrid"};
+static const int CLASS_COUNT = sizeof(CLASS_NAMES) / sizeof(CLASS_NAMES[0]);
+
+struct Tally
+{
+    std::atomic<int> methods{0};
+    std::atomic<int> failures{0};
+    std::atomic<int> classes[CLASS_COUNT];
+    std::atomic<int> little{0};
+    std::atomic<int> differential{0};
+
+    Tally()
+    {
+        for (auto &count : classes)
+            count = 0;
+    }
+};
+
+// Stream every method of a stage through ReadMethod and classify it.
+static void ClassifyStage(const std::string &directory, int stage, Tally &tally)
+{
+    ringing::FileReader reader;
+    if (!bench::OpenStage(reader, directory, stage))
+        return;
+    int pos;
+    if (!reader.Search("", &pos))
+        return;
+
+    ringing::Method method;
+    ringing::Classification classification;
+    while (!reader.EndOfFile())
+    {
+        if (!reader.ReadMethod(method))
+        {
+            tally.failures++;
+            break;
+        }
+        tally.methods++;
+        if (!ringing::Classify(method, classification))
+        {
+            tally.failures++;
+            continue;
+        }
+        tally.classes[classification.methodclass]++;
+        if (classification.little)
+            tally.little++;
+        if (classification.differential)
+            tally.differential++;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    const std::string directory = argc > 1 ? argv[1] : "../methods";
+    int threadcount = argc > 2 ? std::atoi(argv[2]) : (int)std::thread::hardware_concurrency();
+    if (threadcount <= 0)
+        threadcount = 1;
+
+    Tally tally;
+    std::atomic<int> nextstage{2};
+    const auto start = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < threadcount; t++)
+        threads.emplace_back([&]
+                             {
+                                 int stage;
+                                 while ((stage = nextstage++) <= ringing::MAX_BELLS)
+                                     ClassifyStage(directory, stage, tally); });
+    for (auto &thread : threads)
+        thread.join();
+
+    const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (tally.methods == 0)
+    {
+        std::printf("No method files found in %s\n", directory.c_str());
+        return 1;
+    }
+
+    for (int i = 0; i < CLASS_COUNT; i++)
+        std::printf("%-14s %6d\n", CLASS_NAMES[i], tally.classes[i].load());
+    std::printf("%-14s %6d\n", "Little", tally.little.load());
+    std::printf("%-14s %6d\n", "Differential", tally.differential.load());
+    std::printf("%d methods (%d failures) in %.3f ms on %d threads: %.2f M methods/s\n",
+                tally.methods.load(), tally.failures.load(), elapsed * 1e3, threadcount,
+                tally.methods / elapsed / 1e6);
+    return tally.methods > 0 ? 0 : 1;
+}
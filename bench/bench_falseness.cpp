@@ -0,0 +1,154 @@
+// Computes the false course heads of every treble-hunting method in the
+// method library and groups methods by falseness. Checks that the falseness
+// index of each stage lists the methods with each signature.
+// Usage: bench_falseness [METHODS_DIR [TITLE]]
+// With TITLE, lists the methods with the same false course heads as that method,
+// found through the falseness index.
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+#include "bench.hpp"
+#include "../src/charset/charset.cpp"
+#include "../src/ringing/row.cpp"
+#include "../src/ringing/method.cpp"
+#include "../src/ringing/packedrow.cpp"
+#include "../src/ringing/filereader.cpp"
+#include "../src/ringing/falseness.cpp"
+
+// The stage followed by the sorted course heads, which identifies a method's falseness exactly.
+static std::vector<uint64_t> HeadsKey(int stage, const ringing::FalseCourseHeads &falseness)
+{
+    std::vector<uint64_t> key(1, stage);
+    for (int i = 0; i < falseness.Count(); i++)
+        key.push_back(falseness.Get(i).bits);
+    return key;
+}
+
+// Compare the positions the falseness index lists for each signature with those computed.
+static int CheckIndex(ringing::FileReader &reader, const std::map<uint32_t, std::vector<int>> &computed)
+{
+    int mismatches = 0;
+    ringing::AttributeIterator iterator;
+    for (const auto &entry : computed)
+    {
+        std::vector<int> listed;
+        int pos;
+        if (reader.QueryAttribute(ringing::MethodAttribute::Falseness, entry.first, iterator))
+            while (reader.NextMatch(iterator, pos))
+                listed.push_back(pos);
+        if (listed != entry.second)
+            mismatches++;
+    }
+    return mismatches;
+}
+
+int main(int argc, char **argv)
+{
+    const std::string directory = argc > 1 ? argv[1] : "../methods";
+    const char *query = argc > 2 ? argv[2] : nullptr;
+
+    static ringing::Method method;
+    static ringing::CompiledMethod compiled;
+    static ringing::FalseCourseHeads falseness, queryfalseness;
+    std::map<std::vector<uint64_t>, std::vector<std::string>> groups;
+    std::map<uint32_t, std::set<std::vector<uint64_t>>> bysignature;
+    int querystage = 0;
+    int methods = 0, computed = 0, indexed = 0, mismatches = 0;
+    double elapsed = 0, slowest = 0;
+
+    for (int stage = 2; stage <= ringing::MAX_BELLS; stage++)
+    {
+        ringing::FileReader reader;
+        if (!bench::OpenStage(reader, directory, stage))
+            continue;
+        if (!reader.Search("", nullptr))
+            continue;
+        std::map<uint32_t, std::vector<int>> positions;
+        while (!reader.EndOfFile())
+        {
+            const int pos = reader.Tell();
+            if (!reader.ReadMethod(method))
+                break;
+            methods++;
+            if (!compiled.Compile(method))
+                continue;
+            const auto start = std::chrono::steady_clock::now();
+            const bool ok = falseness.Compute(compiled);
+            const double taken = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            elapsed += taken;
+            if (!ok)
+                continue;
+            if (taken > slowest)
+                slowest = taken;
+            computed++;
+
+            const uint32_t signature = falseness.Signature();
+            const std::vector<uint64_t> key = HeadsKey(stage, falseness);
+            groups[key].push_back(method.title);
+            bysignature[signature].insert(key);
+            positions[signature].push_back(pos);
+            if (query != nullptr && querystage == 0 && std::string(method.title) == query)
+            {
+                querystage = stage;
+                queryfalseness = falseness;
+            }
+        }
+        if (reader.HasAttributeIndex(ringing::MethodAttribute::Falseness))
+        {
+            indexed++;
+            mismatches += CheckIndex(reader, positions);
+        }
+    }
+
+    if (methods == 0)
+    {
+        std::printf("No method files found in %s\n", directory.c_str());
+        return 1;
+    }
+    int collisions = 0;
+    for (const auto &entry : bysignature)
+        collisions += entry.second.size() - 1;
+    std::printf("%d methods read, false course heads of %d computed in %.3f ms (slowest %.3f ms)\n",
+                methods, computed, elapsed * 1e3, slowest * 1e3);
+    std::printf("%zu distinct false course head sets, %zu signatures (%d collisions)\n",
+                groups.size(), bysignature.size(), collisions);
+    if (indexed > 0)
+        std::printf("falseness index of %d stages: %d signatures listed differently\n", indexed, mismatches);
+    if (query != nullptr)
+    {
+        if (querystage == 0)
+        {
+            std::printf("%s: not found\n", query);
+            return 1;
+        }
+        ringing::FileReader reader;
+        ringing::AttributeIterator iterator;
+        if (!bench::OpenStage(reader, directory, querystage) ||
+            !reader.HasAttributeIndex(ringing::MethodAttribute::Falseness))
+        {
+            std::printf("Same falseness as %s (no falseness index):\n", query);
+            for (const std::string &title : groups[HeadsKey(querystage, queryfalseness)])
+                std::printf("  %s\n", title.c_str());
+            return mismatches == 0 ? 0 : 1;
+        }
+        std::printf("Same falseness as %s:\n", query);
+        int pos, others = 0;
+        if (reader.QueryAttribute(ringing::MethodAttribute::Falseness, queryfalseness.Signature(), iterator))
+            while (reader.NextMatch(iterator, pos))
+            {
+                // methods with different falseness can share a signature
+                reader.Seek(pos);
+                if (!reader.ReadMethod(method) || !compiled.Compile(method) || !falseness.Compute(compiled))
+                    continue;
+                if (falseness.SameAs(queryfalseness))
+                    std::printf("  %s\n", method.title);
+                else
+                    others++;
+            }
+        if (others > 0)
+            std::printf("(%d more with the same signature but different false course heads)\n", others);
+    }
+    return mismatches == 0 ? 0 : 1;
+}
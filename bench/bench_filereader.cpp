@@ -0,0 +1,465 @@
+// Compares FileReader against MappedFileReader for summary scans, full method
+// reads and searches over every stage, read from library.ccml if there is one
+// or else from the stage files, and checks that they agree. Also counts the OS
+// reads FileReader's block cache issues for each workload, and, if there are
+// both a library and stage files, compares switching stage within the library
+// against reopening each stage file. Files with an index also time finding a page of
+// titles containing a search anywhere, against checking every title in turn.
+// Files with secondary indexes time finding methods by place notation, and by
+// lead length and hunt bells together, against reading every method.
+
+#include <algorithm>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+#include "bench.hpp"
+#include "../src/charset/charset.cpp"
+#include "../src/ringing/row.cpp"
+#include "../src/ringing/method.cpp"
+#include "../src/ringing/filereader.cpp"
+
+// Search for one in every SEARCH_STRIDE titles.
+static const int SEARCH_STRIDE = 16;
+// Summaries read after switching stage, as for the first page of search results.
+static const int SWITCH_PAGE_LENGTH = 7;
+// Results found by each infix search: a page, and the start of the next.
+static const int INFIX_PAGE_LENGTH = 8;
+
+template <typename Reader>
+static int ScanSummaries(Reader &reader, std::vector<std::string> *titles = nullptr)
+{
+    charset::MBChar title[ringing::MAX_METHOD_TITLE_LENGTH];
+    int count = 0;
+    reader.Seek(0);
+    if (!reader.Search("", nullptr))
+        return 0;
+    while (!reader.EndOfFile() && reader.ReadMethodSummary(nullptr, nullptr, title))
+    {
+        if (titles != nullptr)
+            titles->push_back(title);
+        bench::Consume(title);
+        count++;
+    }
+    return count;
+}
+
+static int ReadAllFileReader(ringing::FileReader &reader)
+{
+    static ringing::Method method;
+    int count = 0;
+    if (!reader.Search("", nullptr))
+        return 0;
+    while (!reader.EndOfFile() && reader.ReadMethod(method))
+    {
+        bench::Consume(method);
+        count++;
+    }
+    return count;
+}
+
+static int ReadAllViews(ringing::MappedFileReader &reader)
+{
+    ringing::MethodView view;
+    int count = 0;
+    if (!reader.Search("", nullptr))
+        return 0;
+    while (!reader.EndOfFile() && reader.ReadMethodView(view))
+    {
+        bench::Consume(view);
+        count++;
+    }
+    return count;
+}
+
+template <typename Reader>
+static int SearchAll(Reader &reader, const std::vector<std::string> &keys, std::vector<int> *positions = nullptr)
+{
+    for (const std::string &key : keys)
+    {
+        int pos = -1;
+        reader.Search(key.c_str(), &pos);
+        if (positions != nullptr)
+            positions->push_back(pos);
+        bench::Consume(pos);
+    }
+    return keys.size();
+}
+
+// Find the first page of titles containing each key, as the search screen does.
+template <typename Reader>
+static int InfixSearchAll(Reader &reader, const std::vector<std::string> &keys,
+                          std::vector<int> *ordinals = nullptr)
+{
+    int found[INFIX_PAGE_LENGTH];
+    for (const std::string &key : keys)
+    {
+        int count = 0;
+        reader.SearchInfix(key.c_str(), 0, found, INFIX_PAGE_LENGTH, count);
+        if (ordinals != nullptr)
+            ordinals->insert(ordinals->end(), found, found + count);
+        bench::Consume(count);
+    }
+    return keys.size();
+}
+
+// As InfixSearchAll, by reading every title in order until a page is found.
+static int InfixScanAll(ringing::FileReader &reader, const std::vector<std::string> &keys,
+                        std::vector<int> *ordinals = nullptr)
+{
+    charset::MBChar title[ringing::MAX_METHOD_TITLE_LENGTH];
+    for (const std::string &key : keys)
+    {
+        int count = 0;
+        reader.Search("", nullptr);
+        for (int ordinal = 0; count < INFIX_PAGE_LENGTH && !reader.EndOfFile(); ordinal++)
+        {
+            if (!reader.ReadMethodSummary(nullptr, nullptr, title))
+                break;
+            if (charset::ContainsSearch(key.c_str(), title))
+            {
+                if (ordinals != nullptr)
+                    ordinals->push_back(ordinal);
+                count++;
+            }
+        }
+        bench::Consume(count);
+    }
+    return keys.size();
+}
+
+static bool SamePn(const ringing::Method &a, const ringing::Method &b)
+{
+    return a.leadlength == b.leadlength && std::equal(a.pn, a.pn + a.leadlength, b.pn);
+}
+
+// Find the methods with the place notation of each of methods, as when identifying a method by it.
+template <typename Reader>
+static int PnQueryAll(Reader &reader, const std::vector<ringing::Method> &methods,
+                      std::vector<int> *positions = nullptr)
+{
+    static ringing::Method found;
+    ringing::AttributeIterator iterator;
+    for (const ringing::Method &method : methods)
+    {
+        int count = 0, pos;
+        if (reader.QueryAttribute(ringing::MethodAttribute::PnHash, ringing::HashPlaceNotation(method), iterator))
+            while (reader.NextMatch(iterator, pos))
+            {
+                // methods with different place notation can share a hash
+                reader.Seek(pos);
+                if (!reader.ReadMethod(found))
+                    break;
+                if (!SamePn(found, method))
+                    continue;
+                if (positions != nullptr)
+                    positions->push_back(pos);
+                count++;
+            }
+        bench::Consume(count);
+    }
+    return methods.size();
+}
+
+// Find the methods with each lead length and hunt bells, as for "2-hunt methods with a 32-change lead".
+template <typename Reader>
+static int AttributeQueryAll(Reader &reader, const std::vector<std::pair<int, int>> &queries,
+                             std::vector<int> *positions = nullptr)
+{
+    ringing::AttributeIterator iterators[2];
+    for (const std::pair<int, int> &query : queries)
+    {
+        int count = 0, pos;
+        if (reader.QueryAttribute(ringing::MethodAttribute::LeadLength, query.first, iterators[0]) &&
+            reader.QueryAttribute(ringing::MethodAttribute::HuntBells, query.second, iterators[1]))
+            while (reader.NextCommonMatch(iterators, 2, pos))
+            {
+                if (positions != nullptr)
+                    positions->push_back(pos);
+                count++;
+            }
+        bench::Consume(count);
+    }
+    return queries.size();
+}
+
+// As PnQueryAll and AttributeQueryAll, by reading every method in turn.
+static int PnScanAll(ringing::FileReader &reader, const std::vector<ringing::Method> &methods,
+                     std::vector<int> *positions = nullptr)
+{
+    static ringing::Method found;
+    for (const ringing::Method &method : methods)
+    {
+        int count = 0;
+        reader.Search("", nullptr);
+        while (!reader.EndOfFile())
+        {
+            const int pos = reader.Tell();
+            if (!reader.ReadMethod(found))
+                break;
+            if (!SamePn(found, method))
+                continue;
+            if (positions != nullptr)
+                positions->push_back(pos);
+            count++;
+        }
+        bench::Consume(count);
+    }
+    return methods.size();
+}
+
+static int AttributeScanAll(ringing::FileReader &reader, const std::vector<std::pair<int, int>> &queries,
+                            std::vector<int> *positions = nullptr)
+{
+    static ringing::Method found;
+    for (const std::pair<int, int> &query : queries)
+    {
+        int count = 0;
+        reader.Search("", nullptr);
+        while (!reader.EndOfFile())
+        {
+            const int pos = reader.Tell();
+            if (!reader.ReadMethod(found))
+                break;
+            if (found.leadlength != query.first || found.huntbells != query.second)
+                continue;
+            if (positions != nullptr)
+                positions->push_back(pos);
+            count++;
+        }
+        bench::Consume(count);
+    }
+    return queries.size();
+}
+
+// Open the first page of every stage in turn, from each stage file or from a library.
+static int SwitchStages(ringing::FileReader &reader, const std::string &directory, bool library,
+                        std::vector<std::string> *titles = nullptr)
+{
+    charset::MBChar title[ringing::MAX_METHOD_TITLE_LENGTH];
+    int switches = 0;
+    for (int stage = 2; stage <= ringing::MAX_BELLS; stage++)
+    {
+        if (library ? !reader.SelectStage(stage) : !reader.TryOpen(bench::StageFilename(directory, stage).c_str()))
+            continue;
+        switches++;
+        if (!reader.Search("", nullptr))
+            continue;
+        for (int i = 0; i < SWITCH_PAGE_LENGTH && !reader.EndOfFile(); i++)
+        {
+            if (!reader.ReadMethodSummary(nullptr, nullptr, title))
+                break;
+            if (titles != nullptr)
+                titles->push_back(title);
+            bench::Consume(title);
+        }
+    }
+    return switches;
+}
+
+static void ReportReads(const char *name, const ringing::FileReader &reader)
+{
+    const ringing::FileReadStats &stats = reader.GetReadStats();
+    std::printf("%-32s %10d OS reads %10d bytes\n", name, stats.osreads, stats.bytesfetched);
+}
+
+int main(int argc, char **argv)
+{
+    const std::string directory = argc > 1 ? argv[1] : "../methods";
+    int mismatches = 0, files = 0;
+    for (int stage = 2; stage <= ringing::MAX_BELLS; stage++)
+    {
+        const std::string name = "stage " + std::to_string(stage);
+        ringing::FileReader reader;
+        ringing::MappedFileReader mapped;
+        if (!bench::OpenStage(reader, directory, stage) || !bench::OpenStage(mapped, directory, stage))
+            continue;
+        files++;
+
+        std::vector<std::string> titles, mappedtitles;
+        const int count = ScanSummaries(reader, &titles);
+        ScanSummaries(mapped, &mappedtitles);
+        if (titles != mappedtitles)
+        {
+            std::printf("%s: summaries differ\n", name.c_str());
+            mismatches++;
+        }
+
+        std::vector<std::string> keys;
+        for (size_t i = 0; i < titles.size(); i += SEARCH_STRIDE)
+            keys.push_back(titles[i]);
+        std::vector<int> positions, mappedpositions;
+        SearchAll(reader, keys, &positions);
+        SearchAll(mapped, keys, &mappedpositions);
+        if (positions != mappedpositions)
+        {
+            std::printf("%s: search results differ\n", name.c_str());
+            mismatches++;
+        }
+
+        std::printf("%s (%d methods)\n", name.c_str(), count);
+        reader.ResetReadStats();
+        ScanSummaries(reader);
+        ReportReads("  FileReader summaries", reader);
+        reader.ResetReadStats();
+        ReadAllFileReader(reader);
+        ReportReads("  FileReader ReadMethod", reader);
+        reader.ResetReadStats();
+        SearchAll(reader, keys);
+        ReportReads("  FileReader Search", reader);
+
+        bench::Report("  FileReader summaries", "methods",
+                      bench::Throughput([&]
+                                        { return ScanSummaries(reader); }));
+        bench::Report("  MappedFileReader summaries", "methods",
+                      bench::Throughput([&]
+                                        { return ScanSummaries(mapped); }));
+        bench::Report("  FileReader ReadMethod", "methods",
+                      bench::Throughput([&]
+                                        { return ReadAllFileReader(reader); }));
+        bench::Report("  MappedFileReader views", "methods",
+                      bench::Throughput([&]
+                                        { return ReadAllViews(mapped); }));
+        bench::Report("  FileReader Search", "searches",
+                      bench::Throughput([&]
+                                        { return SearchAll(reader, keys); }));
+        bench::Report("  MappedFileReader Search", "searches",
+                      bench::Throughput([&]
+                                        { return SearchAll(mapped, keys); }));
+
+        if (reader.HasAttributeIndex(ringing::MethodAttribute::PnHash) &&
+            reader.HasAttributeIndex(ringing::MethodAttribute::LeadLength) &&
+            reader.HasAttributeIndex(ringing::MethodAttribute::HuntBells))
+        {
+            static ringing::Method method;
+            std::vector<ringing::Method> methods;
+            std::set<std::pair<int, int>> distinct;
+            reader.Search("", nullptr);
+            for (int i = 0; !reader.EndOfFile() && reader.ReadMethod(method); i++)
+                if (i % SEARCH_STRIDE == 0)
+                {
+                    methods.push_back(method);
+                    distinct.insert({method.leadlength, method.huntbells});
+                }
+            const std::vector<std::pair<int, int>> queries(distinct.begin(), distinct.end());
+
+            std::vector<int> found, mappedfound, scannedfound;
+            PnQueryAll(reader, methods, &found);
+            PnQueryAll(mapped, methods, &mappedfound);
+            PnScanAll(reader, methods, &scannedfound);
+            if (found != mappedfound || found != scannedfound)
+            {
+                std::printf("%s: place notation query results differ\n", name.c_str());
+                mismatches++;
+            }
+            found.clear();
+            mappedfound.clear();
+            scannedfound.clear();
+            AttributeQueryAll(reader, queries, &found);
+            AttributeQueryAll(mapped, queries, &mappedfound);
+            AttributeScanAll(reader, queries, &scannedfound);
+            if (found != mappedfound || found != scannedfound)
+            {
+                std::printf("%s: lead length and hunt bells query results differ\n", name.c_str());
+                mismatches++;
+            }
+
+            reader.ResetReadStats();
+            PnQueryAll(reader, methods);
+            ReportReads("  FileReader pn query", reader);
+            reader.ResetReadStats();
+            AttributeQueryAll(reader, queries);
+            ReportReads("  FileReader attribute query", reader);
+            reader.ResetReadStats();
+            AttributeScanAll(reader, queries);
+            ReportReads("  FileReader attribute scan", reader);
+            bench::Report("  FileReader pn query", "queries",
+                          bench::Throughput([&]
+                                            { return PnQueryAll(reader, methods); }));
+            bench::Report("  MappedFileReader pn query", "queries",
+                          bench::Throughput([&]
+                                            { return PnQueryAll(mapped, methods); }));
+            bench::Report("  FileReader pn scan", "queries",
+                          bench::Throughput([&]
+                                            { return PnScanAll(reader, methods); }));
+            bench::Report("  FileReader attribute query", "queries",
+                          bench::Throughput([&]
+                                            { return AttributeQueryAll(reader, queries); }));
+            bench::Report("  MappedFileReader attribute query", "queries",
+                          bench::Throughput([&]
+                                            { return AttributeQueryAll(mapped, queries); }));
+            bench::Report("  FileReader attribute scan", "queries",
+                          bench::Throughput([&]
+                                            { return AttributeScanAll(reader, queries); }));
+        }
+
+        if (!reader.HasIndex())
+            continue;
+        // search for the rest of each title after its first word
+        std::vector<std::string> infixkeys;
+        for (const std::string &key : keys)
+            if (key.find(' ') != std::string::npos)
+                infixkeys.push_back(key.substr(key.find(' ') + 1));
+        std::vector<int> ordinals, mappedordinals, scannedordinals;
+        InfixSearchAll(reader, infixkeys, &ordinals);
+        InfixSearchAll(mapped, infixkeys, &mappedordinals);
+        InfixScanAll(reader, infixkeys, &scannedordinals);
+        if (ordinals != mappedordinals || ordinals != scannedordinals)
+        {
+            std::printf("%s: infix search results differ\n", name.c_str());
+            mismatches++;
+        }
+        std::printf("  infix searches use %s\n", reader.HasTrigrams() ? "the trigram index" : "every title");
+        reader.ResetReadStats();
+        InfixSearchAll(reader, infixkeys);
+        ReportReads("  FileReader SearchInfix", reader);
+        reader.ResetReadStats();
+        InfixScanAll(reader, infixkeys);
+        ReportReads("  FileReader infix scan", reader);
+        bench::Report("  FileReader SearchInfix", "searches",
+                      bench::Throughput([&]
+                                        { return InfixSearchAll(reader, infixkeys); }));
+        bench::Report("  MappedFileReader SearchInfix", "searches",
+                      bench::Throughput([&]
+                                        { return InfixSearchAll(mapped, infixkeys); }));
+        bench::Report("  FileReader infix scan", "searches",
+                      bench::Throughput([&]
+                                        { return InfixScanAll(reader, infixkeys); }));
+    }
+    if (files == 0)
+        std::printf("No method files found in %s\n", directory.c_str());
+
+    const std::string libraryname = directory + "/library.ccml";
+    ringing::FileReader library, stagefiles;
+    if (library.TryOpen(libraryname.c_str()) && library.IsLibrary())
+    {
+        std::vector<std::string> titles, librarytitles;
+        if (SwitchStages(stagefiles, directory, false, &titles) == 0)
+        {
+            std::printf("%s: no stage files to compare with\n", libraryname.c_str());
+            return files > 0 && mismatches == 0 ? 0 : 1;
+        }
+        SwitchStages(library, directory, true, &librarytitles);
+        if (titles != librarytitles)
+        {
+            std::printf("%s: first pages differ\n", libraryname.c_str());
+            mismatches++;
+        }
+
+        std::printf("%s\n", libraryname.c_str());
+        stagefiles.ResetReadStats();
+        SwitchStages(stagefiles, directory, false);
+        ReportReads("  stage files, reopening", stagefiles);
+        library.ResetReadStats();
+        SwitchStages(library, directory, true);
+        ReportReads("  library, SelectStage", library);
+
+        bench::Report("  stage files, reopening", "switches",
+                      bench::Throughput([&]
+                                        { return SwitchStages(stagefiles, directory, false); }));
+        bench::Report("  library, SelectStage", "switches",
+                      bench::Throughput([&]
+                                        { return SwitchStages(library, directory, true); }));
+    }
+    return files > 0 && mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,201 @@
+// Measures the latency of fuzzy title searches over every stage, for titles
+// with one or two typos, against computing the edit distance of every title.
+// Also checks that FileReader and MappedFileReader agree with that scan. Stages
+// are read from library.ccml, or from the stage files if there is no library.
+// Usage: bench_fuzzy [METHODS_DIR]
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+#include "bench.hpp"
+#include "../src/charset/charset.cpp"
+#include "../src/ringing/row.cpp"
+#include "../src/ringing/method.cpp"
+#include "../src/ringing/filereader.cpp"
+
+// Search for a mistyped start of one in every SEARCH_STRIDE titles.
+static const int SEARCH_STRIDE = 16;
+// Characters of each title searched for, as typed on the search screen.
+static const int SEARCH_LENGTH = 12;
+// Results found by each search: three pages of the search screen.
+static const int RESULT_COUNT = 21;
+
+static std::string Normalise(const charset::MBChar *title)
+{
+    std::string text;
+    while (charset::NonMBChar c = charset::ReadSearchChar(title))
+        text += c;
+    return text;
+}
+
+// Least edits between query and the start of text.
+static int PrefixDistance(const std::string &query, const std::string &text)
+{
+    std::vector<int> row(query.size() + 1), next(query.size() + 1);
+    for (size_t j = 0; j <= query.size(); j++)
+        row[j] = j;
+    int best = row[query.size()];
+    for (size_t i = 0; i < text.size(); i++)
+    {
+        next[0] = i + 1;
+        for (size_t j = 1; j <= query.size(); j++)
+            next[j] = std::min({row[j - 1] + (query[j - 1] == text[i] ? 0 : 1), row[j] + 1, next[j - 1] + 1});
+        row.swap(next);
+        best = std::min(best, row[query.size()]);
+    }
+    return best;
+}
+
+// Substitute, delete or insert letters of text.
+static std::string Mistype(std::string text, int typos, std::mt19937 &random)
+{
+    for (int i = 0; i < typos && text.size() > 1; i++)
+    {
+        const size_t at = random() % text.size();
+        const char letter = 'A' + random() % 26;
+        switch (random() % 3)
+        {
+        case 0:
+            text[at] = letter;
+            break;
+        case 1:
+            text.erase(at, 1);
+            break;
+        default:
+            text.insert(at, 1, letter);
+            break;
+        }
+    }
+    return text;
+}
+
+struct Matches
+{
+    std::vector<int> ordinals;
+    std::vector<int> distances;
+
+    bool operator==(const Matches &m) const { return ordinals == m.ordinals && distances == m.distances; }
+    bool operator!=(const Matches &m) const { return !(*this == m); }
+};
+
+template <typename Reader>
+static Matches SearchFuzzy(Reader &reader, const std::string &query, int maxdistance)
+{
+    int ordinals[RESULT_COUNT], distances[RESULT_COUNT], count = 0;
+    reader.SearchFuzzy(query.c_str(), maxdistance, ordinals, distances, RESULT_COUNT, count);
+    return {std::vector<int>(ordinals, ordinals + count), std::vector<int>(distances, distances + count)};
+}
+
+// As SearchFuzzy, by computing the distance of every title, already normalised in memory.
+static Matches ScanFuzzy(const std::vector<std::string> &titles, const std::string &query, int maxdistance)
+{
+    std::vector<std::pair<int, int>> found;
+    for (size_t ordinal = 0; ordinal < titles.size(); ordinal++)
+    {
+        const int distance = PrefixDistance(query, titles[ordinal]);
+        if (distance <= maxdistance)
+            found.push_back({distance, ordinal});
+    }
+    std::stable_sort(found.begin(), found.end(),
+                     [](const std::pair<int, int> &a, const std::pair<int, int> &b)
+                     { return a.first < b.first; });
+    if (found.size() > RESULT_COUNT)
+        found.resize(RESULT_COUNT);
+    Matches matches;
+    for (const std::pair<int, int> &match : found)
+    {
+        matches.ordinals.push_back(match.second);
+        matches.distances.push_back(match.first);
+    }
+    return matches;
+}
+
+// Mean microseconds per query of fn(query).
+template <typename F>
+static double Latency(const std::vector<std::string> &queries, F fn)
+{
+    using clock = std::chrono::steady_clock;
+    int runs = 0;
+    const auto start = clock::now();
+    double elapsed;
+    do
+    {
+        for (const std::string &query : queries)
+            bench::Consume(fn(query));
+        runs += queries.size();
+        elapsed = std::chrono::duration<double>(clock::now() - start).count();
+    } while (elapsed < 0.5);
+    return elapsed / runs * 1e6;
+}
+
+int main(int argc, char **argv)
+{
+    const std::string directory = argc > 1 ? argv[1] : "../methods";
+    std::mt19937 random(22);
+    int mismatches = 0, files = 0;
+    for (int stage = 2; stage <= ringing::MAX_BELLS; stage++)
+    {
+        const std::string name = "stage " + std::to_string(stage);
+        ringing::FileReader reader;
+        ringing::MappedFileReader mapped;
+        if (!bench::OpenStage(reader, directory, stage) || !bench::OpenStage(mapped, directory, stage) ||
+            !reader.HasIndex())
+            continue;
+        files++;
+
+        std::vector<std::string> titles;
+        charset::MBChar title[ringing::MAX_METHOD_TITLE_LENGTH];
+        int first, count;
+        reader.SearchOrdinals("", first, count);
+        for (int ordinal = 0; ordinal < count; ordinal++)
+            if (reader.SeekOrdinal(ordinal) && reader.ReadMethodSummary(nullptr, nullptr, title))
+                titles.push_back(Normalise(title));
+        std::printf("%s (%d methods)\n", name.c_str(), count);
+
+        for (int typos = 1; typos <= 2; typos++)
+        {
+            std::vector<std::string> queries;
+            std::vector<int> originals;
+            for (size_t i = 0; i < titles.size(); i += SEARCH_STRIDE)
+            {
+                queries.push_back(Mistype(titles[i].substr(0, SEARCH_LENGTH), typos, random));
+                originals.push_back(i);
+            }
+
+            int found = 0, osreads = 0;
+            for (size_t q = 0; q < queries.size(); q++)
+            {
+                reader.ResetReadStats();
+                const Matches matches = SearchFuzzy(reader, queries[q], typos);
+                osreads += reader.GetReadStats().osreads;
+                if (matches != SearchFuzzy(mapped, queries[q], typos) ||
+                    matches != ScanFuzzy(titles, queries[q], typos))
+                {
+                    std::printf("%s: fuzzy results for '%s' differ\n", name.c_str(), queries[q].c_str());
+                    mismatches++;
+                }
+                for (int ordinal : matches.ordinals)
+                    found += ordinal == originals[q];
+            }
+
+            std::printf("  %d typo%s: %zu queries, %.0f%% find the title, %.1f OS reads per query\n",
+                        typos, typos == 1 ? "" : "s", queries.size(),
+                        queries.empty() ? 0.0 : 100.0 * found / queries.size(),
+                        queries.empty() ? 0.0 : (double)osreads / queries.size());
+            std::printf("%-32s %10.1f us/query\n", "  FileReader SearchFuzzy",
+                        Latency(queries, [&](const std::string &query)
+                                { return SearchFuzzy(reader, query, typos).ordinals.size(); }));
+            std::printf("%-32s %10.1f us/query\n", "  MappedFileReader SearchFuzzy",
+                        Latency(queries, [&](const std::string &query)
+                                { return SearchFuzzy(mapped, query, typos).ordinals.size(); }));
+            std::printf("%-32s %10.1f us/query\n", "  distance of every title",
+                        Latency(queries, [&](const std::string &query)
+                                { return ScanFuzzy(titles, query, typos).ordinals.size(); }));
+        }
+    }
+    if (files == 0)
+        std::printf("No indexed method files found in %s\n", directory.c_str());
+    return files > 0 && mismatches == 0 ? 0 : 1;
+}
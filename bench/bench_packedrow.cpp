@@ -0,0 +1,102 @@
+// Compares permutation algebra on ringing::Row against ringing::PackedRow.
+
+#include <random>
+#include "bench.hpp"
+#include "../src/ringing/row.cpp"
+#include "../src/ringing/packedrow.cpp"
+
+static const int ROW_COUNT = 1024;
+
+static ringing::Row RandomRow(std::mt19937 &rng, int stage)
+{
+    ringing::Row row = ringing::Row::Rounds(stage);
+    for (int i = stage - 1; i > 0; i--)
+    {
+        int j = std::uniform_int_distribution<int>(0, i)(rng);
+        ringing::Bell temp = row.row[i];
+        row.row[i] = row.row[j];
+        row.row[j] = temp;
+    }
+    return row;
+}
+
+static ringing::Row InverseRow(const ringing::Row &row)
+{
+    ringing::Row inverse = row;
+    for (int i = 0; i < row.stage; i++)
+        inverse.row[row.row[i]] = i;
+    return inverse;
+}
+
+int main()
+{
+    std::mt19937 rng(1);
+    static ringing::Row rows[ROW_COUNT];
+    static ringing::PackedRow packed[ROW_COUNT];
+
+#ifdef RINGING_PACKEDROW_SSSE3
+    std::printf("PackedRow multiply: SSSE3\n");
+#else
+    std::printf("PackedRow multiply: scalar\n");
+#endif
+
+    for (int stage : {6, 8, 12, 16})
+    {
+        for (int i = 0; i < ROW_COUNT; i++)
+        {
+            rows[i] = RandomRow(rng, stage);
+            packed[i] = ringing::PackedRow(rows[i]);
+        }
+        std::printf("Stage %d\n", stage);
+
+        bench::Report("  Row multiply", "ops",
+                      bench::Throughput([&]
+                                        {
+                                            ringing::Row acc = rows[0];
+                                            for (int i = 1; i < ROW_COUNT; i++)
+                                                acc = acc * rows[i];
+                                            bench::Consume(acc);
+                                            return ROW_COUNT - 1; }));
+        bench::Report("  PackedRow multiply", "ops",
+                      bench::Throughput([&]
+                                        {
+                                            ringing::PackedRow acc = packed[0];
+                                            for (int i = 1; i < ROW_COUNT; i++)
+                                                acc = acc * packed[i];
+                                            bench::Consume(acc);
+                                            return ROW_COUNT - 1; }));
+        bench::Report("  Row inverse", "ops",
+                      bench::Throughput([&]
+                                        {
+                                            for (int i = 0; i < ROW_COUNT; i++)
+                                                bench::Consume(InverseRow(rows[i]));
+                                            return ROW_COUNT; }));
+        bench::Report("  PackedRow inverse", "ops",
+                      bench::Throughput([&]
+                                        {
+                                            for (int i = 0; i < ROW_COUNT; i++)
+                                                bench::Consume(packed[i].Inverse());
+                                            return ROW_COUNT; }));
+        bench::Report("  PackedRow place of bell", "ops",
+                      bench::Throughput([&]
+                                        {
+                                            for (int i = 0; i < ROW_COUNT; i++)
+                                                bench::Consume(packed[i].PlaceOf(i % stage));
+                                            return ROW_COUNT; }));
+        bench::Report("  PackedRow conjugate", "ops",
+                      bench::Throughput([&]
+                                        {
+                                            for (int i = 1; i < ROW_COUNT; i++)
+                                                bench::Consume(packed[i].Conjugate(packed[i - 1]));
+                                            return ROW_COUNT - 1; }));
+        bench::Report("  PackedRow hash", "ops",
+                      bench::Throughput([&]
+                                        {
+                                            uint32_t acc = 0;
+                                            for (int i = 0; i < ROW_COUNT; i++)
+                                                acc += packed[i].Hash(16);
+                                            bench::Consume(acc);
+                                            return ROW_COUNT; }));
+    }
+    return 0;
+}
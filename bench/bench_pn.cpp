@@ -0,0 +1,61 @@
+// Compares applying place notation with ParsePlaceNotation on every row
+// against applying a CompiledMethod's precomputed changes.
+
+#include "bench.hpp"
+#include "../src/ringing/row.cpp"
+#include "../src/ringing/method.cpp"
+#include "../src/test_methods.hpp"
+
+static int CourseParsed(const ringing::Method &method)
+{
+    ringing::ChangeDirection backdirections[ringing::MAX_BELLS];
+    ringing::Row row = ringing::Row::Rounds(method.stage);
+    int rows = 0;
+    for (int lead = 0; lead < method.leadcount; lead++)
+        for (int pn_i = 0; pn_i < method.leadlength; pn_i++)
+        {
+            row.ApplyPn(method.pn[pn_i], nullptr, backdirections);
+            bench::Consume(backdirections);
+            rows++;
+        }
+    bench::Consume(row);
+    return rows;
+}
+
+static int CourseCompiled(const ringing::CompiledMethod &compiled, int leadcount)
+{
+    ringing::Row row = ringing::Row::Rounds(compiled.stage);
+    int rows = 0;
+    for (int lead = 0; lead < leadcount; lead++)
+        for (int pn_i = 0; pn_i < compiled.leadlength; pn_i++)
+        {
+            const ringing::Change &change = compiled.GetChange(pn_i);
+            row.ApplyCompiled(change);
+            bench::Consume(change.backdirections);
+            rows++;
+        }
+    bench::Consume(row);
+    return rows;
+}
+
+int main()
+{
+    const ringing::Method *methods[] = {&PlainBob6, &Grandsire7, &Stedman7, &PlainBob12};
+    static ringing::CompiledMethod compiled;
+    for (const ringing::Method *method : methods)
+    {
+        if (!compiled.Compile(*method))
+        {
+            std::printf("%s: failed to compile\n", method->title);
+            return 1;
+        }
+        std::printf("%s (%d distinct changes)\n", method->title, compiled.changecount);
+        bench::Report("  ParsePlaceNotation", "rows",
+                      bench::Throughput([&]
+                                        { return CourseParsed(*method); }));
+        bench::Report("  ApplyCompiled", "rows",
+                      bench::Throughput([&]
+                                        { return CourseCompiled(compiled, method->leadcount); }));
+    }
+    return 0;
+}
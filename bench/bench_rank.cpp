@@ -0,0 +1,44 @@
+// Measures Row::Rank and Row::FromRank throughput for stages 4 to 16.
+
+#include "bench.hpp"
+#include "../src/ringing/row.cpp"
+
+static const int ROW_COUNT = 1024;
+
+int main()
+{
+    static ringing::Row rows[ROW_COUNT];
+    static uint64_t ranks[ROW_COUNT];
+    for (int stage = 4; stage <= ringing::MAX_BELLS; stage++)
+    {
+        // spread the ranks over the whole range for the stage
+        const uint64_t step = ringing::FACTORIALS[stage] / ROW_COUNT + 1;
+        for (int i = 0; i < ROW_COUNT; i++)
+        {
+            ranks[i] = (i * step) % ringing::FACTORIALS[stage];
+            rows[i] = ringing::Row::FromRank(stage, ranks[i]);
+            if (rows[i].Rank() != ranks[i])
+            {
+                std::printf("Stage %d: rank %llu does not round trip\n", stage, (unsigned long long)ranks[i]);
+                return 1;
+            }
+        }
+
+        std::printf("Stage %d\n", stage);
+        bench::Report("  Rank", "rows",
+                      bench::Throughput([&]
+                                        {
+                                            uint64_t acc = 0;
+                                            for (int i = 0; i < ROW_COUNT; i++)
+                                                acc += rows[i].Rank();
+                                            bench::Consume(acc);
+                                            return ROW_COUNT; }));
+        bench::Report("  FromRank", "rows",
+                      bench::Throughput([&]
+                                        {
+                                            for (int i = 0; i < ROW_COUNT; i++)
+                                                bench::Consume(ringing::Row::FromRank(stage, ranks[i]));
+                                            return ROW_COUNT; }));
+    }
+    return 0;
+}
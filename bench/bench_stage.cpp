@@ -0,0 +1,116 @@
+// Compares the generic Row methods, which loop to a runtime stage, against
+// the kernels dispatched once per method by GetRowKernels: StageKernels up to
+// MAX_SPECIALISED_STAGE, and the generic methods themselves above it.
+
+#include "bench.hpp"
+#include "../src/ringing/row.cpp"
+#include "../src/ringing/method.cpp"
+
+// Plain Bob on an even stage: x1x1...x1x12
+static ringing::Method MakePlainBob(const int stage)
+{
+    ringing::Method method = {};
+    method.stage = stage;
+    std::snprintf(method.title, sizeof(method.title), "Plain Bob (stage %d)", stage);
+    method.leadlength = 2 * stage;
+    for (int i = 0; i < stage; i++)
+    {
+        method.pn[2 * i] = 0;
+        method.pn[2 * i + 1] = 1 | 1 << (stage - 1);
+    }
+    method.pn[2 * stage - 1] = 0b11;
+    method.leadcount = stage - 1;
+    method.huntbells = 1;
+    return method;
+}
+
+static int CourseGenericPn(const ringing::Method &method)
+{
+    ringing::ChangeDirection backdirections[ringing::MAX_BELLS];
+    ringing::Row row = ringing::Row::Rounds(method.stage);
+    int rows = 0;
+    for (int lead = 0; lead < method.leadcount; lead++)
+        for (int pn_i = 0; pn_i < method.leadlength; pn_i++)
+        {
+            row.ApplyPn(method.pn[pn_i], nullptr, backdirections);
+            bench::Consume(backdirections);
+            rows++;
+        }
+    bench::Consume(row);
+    return rows;
+}
+
+static int CourseKernelPn(const ringing::Method &method, const ringing::RowKernels &kernels)
+{
+    ringing::ChangeDirection backdirections[ringing::MAX_BELLS];
+    ringing::Row row = ringing::Row::Rounds(method.stage);
+    int rows = 0;
+    for (int lead = 0; lead < method.leadcount; lead++)
+        for (int pn_i = 0; pn_i < method.leadlength; pn_i++)
+        {
+            kernels.applypn(row, method.pn[pn_i], backdirections);
+            bench::Consume(backdirections);
+            rows++;
+        }
+    bench::Consume(row);
+    return rows;
+}
+
+// Generate rows until rounds, as the renderer and CourseCache do.
+static int CourseGenericCompiled(const ringing::CompiledMethod &compiled)
+{
+    ringing::Row row = ringing::Row::Rounds(compiled.stage);
+    int rows = 0, pn_i = 0;
+    do
+    {
+        row.ApplyCompiled(compiled.GetChange(pn_i++));
+        pn_i %= compiled.leadlength;
+        bench::Consume(row);
+        rows++;
+    } while (pn_i != 0 || !row.IsRounds());
+    return rows;
+}
+
+static int CourseKernelCompiled(const ringing::CompiledMethod &compiled)
+{
+    const ringing::RowKernels &kernels = *compiled.kernels;
+    ringing::Row row = ringing::Row::Rounds(compiled.stage);
+    int rows = 0, pn_i = 0;
+    do
+    {
+        kernels.applycompiled(row, compiled.GetChange(pn_i++));
+        pn_i %= compiled.leadlength;
+        bench::Consume(row);
+        rows++;
+    } while (pn_i != 0 || !kernels.isrounds(row));
+    return rows;
+}
+
+int main()
+{
+    static ringing::CompiledMethod compiled;
+    for (int stage = 4; stage <= ringing::MAX_BELLS; stage += 2)
+    {
+        const ringing::Method method = MakePlainBob(stage);
+        if (!compiled.Compile(method))
+        {
+            std::printf("%s: failed to compile\n", method.title);
+            return 1;
+        }
+        const ringing::RowKernels &kernels = ringing::GetRowKernels(stage);
+        std::printf("%s\n", method.title);
+        bench::Report("  ApplyPn (generic)", "rows",
+                      bench::Throughput([&]
+                                        { return CourseGenericPn(method); }));
+        bench::Report("  ApplyPn (kernel)", "rows",
+                      bench::Throughput([&]
+                                        { return CourseKernelPn(method, kernels); }));
+        bench::Report("  ApplyCompiled (generic)", "rows",
+                      bench::Throughput([&]
+                                        { return CourseGenericCompiled(compiled); }));
+        bench::Report("  ApplyCompiled (kernel)", "rows",
+                      bench::Throughput([&]
+                                        { return CourseKernelCompiled(compiled); }));
+    }
+    return 0;
+}
@@ -0,0 +1,128 @@
+// Measures rows proved per second by the truth prover. Also checks a touch of
+// Plain Bob Minor: three bobs come round, true, and each lead head found by
+// composing lead transpositions matches the rows generated up to it.
+
+#include "bench.hpp"
+#include "../src/ringing/row.cpp"
+#include "../src/ringing/method.cpp"
+#include "../src/ringing/packedrow.cpp"
+#include "../src/ringing/touch.cpp"
+#include "../src/ringing/truth.cpp"
+#include "../src/test_methods.hpp"
+
+static const char *StatusName(ringing::TruthStatus status)
+{
+    switch (status)
+    {
+    case ringing::TruthStatus::Proved:
+        return "true";
+    case ringing::TruthStatus::Repeated:
+        return "false";
+    case ringing::TruthStatus::TooLong:
+        return "too long";
+    default:
+        return "invalid";
+    }
+}
+
+// Bob in Plain Bob Minor: 14 in place of the lead end 12.
+static const ringing::Call Bob6 = {'-', 1, {0b001001}};
+
+static bool SameRow(const ringing::Row &a, const ringing::Row &b)
+{
+    return a.stage == b.stage && ringing::PackedRow(a) == ringing::PackedRow(b);
+}
+
+// Check that LeadHead and Restart agree with generating every row from rounds.
+static int CheckLeadHeads(const ringing::Touch &touch)
+{
+    int mismatches = 0;
+    ringing::TouchRowStream stream = ringing::TouchRowStream(touch), restarted = ringing::TouchRowStream(touch);
+    ringing::Row row, other;
+    for (int index = 0; stream.Next(row); index++)
+    {
+        if (index % touch.LeadLength() != 0)
+            continue;
+        const int lead = index / touch.LeadLength();
+        restarted.Restart(lead);
+        if (!SameRow(row, touch.LeadHead(lead)) || !restarted.Next(other) || !SameRow(other, row))
+        {
+            std::printf("  lead head %d differs from the rows generated up to it\n", lead);
+            mismatches++;
+        }
+    }
+    return mismatches;
+}
+
+static int CheckTouch(ringing::TruthProver &prover)
+{
+    static ringing::CompiledMethod compiled;
+    static ringing::Touch touch;
+    if (!compiled.Compile(PlainBob6) || !touch.SetMethod(compiled) || !touch.AddCall(Bob6) ||
+        !touch.SetCalling("---"))
+    {
+        std::printf("Plain Bob Minor touch could not be set up\n");
+        return 1;
+    }
+
+    int mismatches = CheckLeadHeads(touch);
+    ringing::TouchRowStream stream = ringing::TouchRowStream(touch);
+    ringing::Row row, last;
+    int rows = 0;
+    while (stream.Next(row))
+    {
+        last = row;
+        rows++;
+    }
+    const ringing::TruthResult result = ringing::ProveTouch(prover, touch);
+    std::printf("Plain Bob Minor, three bobs: %s, %d rows, %s\n", StatusName(result.status), result.rowcount,
+                last.IsRounds() ? "comes round" : "does not come round");
+    if (result.status != ringing::TruthStatus::Proved || result.rowcount != 36 || rows != 37 ||
+        !last.IsRounds() || !SameRow(touch.LeadHead(touch.LeadCount()), last))
+    {
+        std::printf("  expected a true touch of 36 rows ending in rounds\n");
+        mismatches++;
+    }
+    bench::Report("  touch", "rows",
+                  bench::Throughput([&]
+                                    { return ringing::ProveTouch(prover, touch).rowcount; }));
+
+    // Bobbing every lead of two courses repeats the first course
+    if (!touch.SetCalling("------") || ringing::ProveTouch(prover, touch).status != ringing::TruthStatus::Repeated)
+    {
+        std::printf("  six bobs should be false\n");
+        mismatches++;
+    }
+    mismatches += CheckLeadHeads(touch);
+    return mismatches;
+}
+
+int main()
+{
+    const ringing::Method *methods[] = {&Original5, &PlainBob6, &Grandsire7, &Stedman7, &PlainBob12};
+    static ringing::CompiledMethod compiled;
+    static ringing::TruthProver prover;
+    for (const ringing::Method *method : methods)
+    {
+        compiled.Compile(*method);
+
+        ringing::TruthResult result = ringing::ProveCourse(prover, compiled);
+        std::printf("%s: %s, %d rows", method->title, StatusName(result.status), result.rowcount);
+        if (result.status == ringing::TruthStatus::Repeated)
+            std::printf(" (row %d repeats row %d)", result.repeatindex, result.firstindex);
+        std::printf("\n");
+        bench::Report("  plain course", "rows",
+                      bench::Throughput([&]
+                                        { return ringing::ProveCourse(prover, compiled).rowcount; }));
+
+        // Two plain courses, which are false from the first row of the second course
+        const ringing::CompiledMethod *leads[2 * 16];
+        const int leadcount = 2 * compiled.leadcount;
+        for (int i = 0; i < leadcount; i++)
+            leads[i] = &compiled;
+        result = ringing::ProveLeads(prover, leads, leadcount);
+        std::printf("  two courses: %s (row %d repeats row %d)\n",
+                    StatusName(result.status), result.repeatindex, result.firstindex);
+    }
+    return CheckTouch(prover) == 0 ? 0 : 1;
+}
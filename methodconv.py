@@ -1,7 +1,9 @@
+import argparse
 import bisect
+import io
+import os
 import re
 import struct
-import sys
 import zipfile
 from abc import ABC, abstractmethod
 from collections import defaultdict
@@ -22,6 +24,9 @@ from prizmunicode.searchmap import (
 
 MAX_METHOD_TITLE_LENGTH = 128
 MAX_PLACE_NOTATION_LENGTH = 256
+MAX_BELLS = 16
+MAX_FALSE_COURSE_HEADS = 1024
+FALSENESS_HASH_CAPACITY = 4096
 
 BELLS = "1234567890ETABCDFGHJKLMNPQRSUVWYZ"
 PN_CROSS = {"-", "X"}
@@ -64,6 +69,18 @@ def convert_pn(pn: str) -> list[int]:
         return convert_pn_part(palindromes[0])
 
 
+def get_pn_symmetry(pn: str) -> int:
+    """Length of the first part of a lead given as two palindromes ("a,b"),
+    or 0 if the lead must be stored in full."""
+    palindromes = pn.upper().split(",")
+    if len(palindromes) != 2:
+        return 0
+    first, second = (convert_pn_part(part) for part in palindromes)
+    if not first or not second:
+        return 0
+    return len(first)
+
+
 class Row:
     stage: int
     row: dict[int, int]  # 0-indexed
@@ -95,6 +112,176 @@ class Row:
         return [i for i in range(self.stage) if self.row[i] == i]
 
 
+CLASS_PRINCIPLE = 0  # ringing::MethodClass
+CLASS_PLAIN = 1
+CLASS_TREBLE_BOB = 2
+CLASS_SURPRISE = 3
+CLASS_DELIGHT = 4
+CLASS_TREBLE_PLACE = 5
+CLASS_ALLIANCE = 6
+CLASS_HYBRID = 7
+CLASS_LITTLE = 1 << 4
+CLASS_DIFFERENTIAL = 1 << 5
+UNCLASSIFIED = 0xFF  # place notation which doesn't give a valid row
+
+
+def apply_pn(row: list[int], pn: int) -> bool:
+    """Swap the bells of row which don't make places in pn, as
+    ringing::ParsePlaceNotation does; False if pn isn't a valid change."""
+    i = 0
+    while i < len(row):
+        if pn & (1 << i):
+            i += 1
+        elif i + 1 < len(row) and not pn & (1 << (i + 1)):
+            row[i], row[i + 1] = row[i + 1], row[i]
+            i += 2
+        else:
+            return False
+    return True
+
+
+def classify_hunt_path(stage: int, pn: list[int], path: list[int]) -> int:
+    """Class of a method from the places of its hunt bell, as
+    ringing::ClassifyHuntPath, with CLASS_LITTLE if it is little."""
+    counts = [0] * stage
+    for place in path:
+        counts[place] += 1
+    minplace, maxplace = min(path), max(path)
+    little = CLASS_LITTLE if minplace > 0 or maxplace < stage - 1 else 0
+    hunted = counts[minplace : maxplace + 1]
+    if any(c == 0 or c % 2 for c in hunted):
+        return CLASS_HYBRID | little
+    if any(c != hunted[0] for c in hunted):
+        return CLASS_ALLIANCE | little
+    if hunted[0] == 2:
+        return CLASS_PLAIN | little
+
+    # treble dodging: dodges in pairs of places, only lying still at the lead and the back
+    if (maxplace - minplace) % 2 == 0:
+        return CLASS_TREBLE_PLACE | little
+    crosssections = internalplaces = 0
+    internal = ((1 << stage) - 1) & ~1 & ~(1 << (stage - 1))
+    for i, place in enumerate(path):
+        to = path[(i + 1) % len(path)]
+        if place == to:
+            if place not in (minplace, maxplace):
+                return CLASS_TREBLE_PLACE | little
+        elif (min(place, to) - minplace) % 2 == 1:  # between pairs of dodging places
+            crosssections += 1
+            if pn[i] & internal:
+                internalplaces += 1
+    if internalplaces == 0:
+        return CLASS_TREBLE_BOB | little
+    if internalplaces == crosssections:
+        return CLASS_SURPRISE | little
+    return CLASS_DELIGHT | little
+
+
+def classify(stage: int, pn: list[int], huntbells: int) -> int:
+    """ringing::Classification::Pack of ringing::Classify for a method, from
+    the path of its lowest-numbered hunt bell and the cycles of its lead
+    head, or UNCLASSIFIED."""
+    if not pn or len(pn) > MAX_PLACE_NOTATION_LENGTH:
+        return UNCLASSIFIED
+    hunts = [bell for bell in range(stage) if huntbells & (1 << bell)]
+    row = list(range(stage))
+    path = []
+    for change in pn:
+        if hunts:
+            path.append(row.index(hunts[0]))
+        if not apply_pn(row, change):
+            return UNCLASSIFIED
+    classification = classify_hunt_path(stage, pn, path) if hunts else CLASS_PRINCIPLE
+
+    cycles = 0
+    seen: set[int] = set()
+    for bell in range(stage):
+        if bell in seen or row[bell] == bell:
+            continue
+        cycles += 1
+        while bell not in seen:
+            seen.add(bell)
+            bell = row[bell]
+    if cycles > 1:
+        classification |= CLASS_DIFFERENTIAL
+    return classification
+
+
+def pack_row(row: tuple[int, ...]) -> int:
+    """ringing::PackedRow of a MAX_BELLS-bell row: a nibble per place, with
+    place 0 in the least significant nibble."""
+    return sum(bell << (4 * place) for place, bell in enumerate(row))
+
+
+def false_course_heads(stage: int, pn: list[int], leadcount: int, fixedtenors: int = 1) -> list[int] | None:
+    """The packed course heads, sorted, of the courses of a method whose
+    treble hunts which share a row with its plain course, as
+    ringing::FalseCourseHeads::Compute; None where that fails."""
+    if stage > MAX_BELLS or not pn or len(pn) > MAX_PLACE_NOTATION_LENGTH:
+        return None
+    if leadcount <= 0 or not 1 <= fixedtenors < stage:
+        return None
+    # rows are padded to MAX_BELLS bells, as PackedRow
+    home = tuple(range(MAX_BELLS))
+    row = list(range(stage))
+    byplace: defaultdict[int, list[tuple[int, ...]]] = defaultdict(list)
+    for change in pn:
+        byplace[row.index(0)].append(tuple(row) + home[stage:])
+        if not apply_pn(row, change):
+            return None
+    if row[0] != 0:
+        return None  # treble must hunt
+    leadhead = tuple(row) + home[stage:]
+    tenor = stage - 1
+
+    def multiply(a: tuple[int, ...], b: tuple[int, ...]) -> tuple[int, ...]:
+        return tuple(a[i] for i in b)
+
+    def inverse(a: tuple[int, ...]) -> tuple[int, ...]:
+        result = [0] * MAX_BELLS
+        for place, bell in enumerate(a):
+            result[bell] = place
+        return tuple(result)
+
+    leadcount = min(leadcount, MAX_PLACE_NOTATION_LENGTH)
+    powers = [home]
+    while len(powers) < leadcount:
+        powers.append(multiply(powers[-1], leadhead))
+    # in a differential the tenor's cycle is shorter than the course, so several powers
+    # can bring a place's bell to the tenor's place
+    powersforplace: defaultdict[int, list[int]] = defaultdict(list)
+    for k, power in enumerate(powers):
+        powersforplace[power[tenor]].append(k)
+
+    transpositions = set()
+    for rows in byplace.values():
+        for r, rrow in enumerate(rows):
+            rinverse = inverse(rrow)
+            transpositions.update(multiply(srow, rinverse) for s, srow in enumerate(rows) if s != r)
+    if len(transpositions) > FALSENESS_HASH_CAPACITY:
+        return None
+
+    heads = set()
+    for transposition in transpositions:
+        for power in powers:
+            lead = multiply(power, transposition)
+            for k in powersforplace[lead.index(tenor)]:
+                head = multiply(lead, powers[k])
+                if all(head[bell] == bell for bell in range(stage - fixedtenors, tenor)):
+                    heads.add(head)
+    if len(heads) > MAX_FALSE_COURSE_HEADS:
+        return None
+    return sorted(pack_row(head) for head in heads)
+
+
+def falseness_signature(stage: int, heads: list[int]) -> int:
+    """ringing::FalseCourseHeads::Signature of sorted packed course heads."""
+    h = stage
+    for bits in heads:
+        h = ((h ^ bits) * 0x100000001B3) & 0xFFFFFFFFFFFFFFFF
+    return (h ^ (h >> 32)) & 0xFFFFFFFF
+
+
 @dataclass(init=True, repr=True, order=False)
 class Method:
     stage: int
@@ -104,8 +291,28 @@ class Method:
     pn: list[int]
     leadcount: int
     huntbells: int
-
-    def dumps(self) -> bytes:
+    symmetry: int = 0  # see get_pn_symmetry
+
+    def get_stored_pn(self, symmetric: bool) -> list[int]:
+        """Place notation as stored: if symmetric, a lead of two palindromes
+        is stored as the first half of each."""
+        if not symmetric or not self.symmetry:
+            return self.pn
+        first = self.symmetry
+        second = (len(self.pn) + 2) // 2 - first
+        return self.pn[:first] + self.pn[2 * first - 1 : 2 * first - 1 + second]
+
+    def dumps(
+        self,
+        prev_title: bytes | None = None,
+        pool_ref: tuple[int, int] | None = None,
+        symmetric: bool = False,
+    ) -> bytes:
+        """Pack the method; if prev_title is given, the title is front-coded
+        against it (pass b"" to start a new block). If pool_ref is given, the
+        first pool_ref[1] stored changes are at index pool_ref[0] of the
+        file's place notation pool, and only the rest are stored. If
+        symmetric, the symmetry is stored, followed by get_stored_pn."""
         titlelength = len(self.raw_title)
         if titlelength + 1 > MAX_METHOD_TITLE_LENGTH:  # +1 for null terminator
             raise ValueError("Method title too long")
@@ -113,20 +320,65 @@ class Method:
         if leadlength > MAX_PLACE_NOTATION_LENGTH:
             raise ValueError("Place notation too long")
 
-        packer = struct.Struct(f"< B {titlelength+1}s H {leadlength}H H H")
+        if prev_title is None:
+            title_fields: tuple[Any, ...] = (titlelength, self.raw_title + b"\0")
+            title_format = f"B {titlelength+1}s"
+        else:
+            shared = len(os.path.commonprefix([prev_title, self.raw_title]))
+            suffix = self.raw_title[shared:]
+            title_fields = (titlelength, shared, suffix + b"\0")
+            title_format = f"B B {len(suffix)+1}s"
+
+        stored_pn = self.get_stored_pn(symmetric)
+        if symmetric:
+            pn_fields: tuple[int, ...] = (leadlength, self.symmetry)
+            pn_format = "H B"
+        else:
+            pn_fields = (leadlength,)
+            pn_format = "H"
+        if pool_ref is not None:
+            pool_index, pool_count = pool_ref
+            pn_fields += (pool_index, pool_count)
+            pn_format += " L H"
+            stored_pn = stored_pn[pool_count:]
+        pn_fields += tuple(stored_pn)
+        pn_format += f" {len(stored_pn)}H"
+
+        packer = struct.Struct(f"< {title_format} {pn_format} H H")
 
         data = packer.pack(
-            titlelength,
-            self.raw_title + b"\0",
-            leadlength,
-            *self.pn,
+            *title_fields,
+            *pn_fields,
             self.leadcount,
             self.huntbells,
         )
         return struct.pack("<H", len(data)) + data
 
-    def dump(self, f: IO[bytes]) -> int:
-        return f.write(self.dumps())
+    def dump(
+        self,
+        f: IO[bytes],
+        prev_title: bytes | None = None,
+        pool_ref: tuple[int, int] | None = None,
+        symmetric: bool = False,
+    ) -> int:
+        return f.write(self.dumps(prev_title, pool_ref, symmetric))
+
+    def get_pn_hash(self) -> int:
+        """32-bit FNV-1a of the whole lead's place notation as little-endian
+        16-bit changes, as ringing::HashPlaceNotation."""
+        h = 0x811C9DC5
+        for byte in struct.pack(f"< {len(self.pn)}H", *self.pn):
+            h = ((h ^ byte) * 0x01000193) & 0xFFFFFFFF
+        return h
+
+    def get_classification(self) -> int:
+        return classify(self.stage, self.pn, self.huntbells)
+
+    def get_falseness_signature(self) -> int | None:
+        """Signature of the false course heads with the tenor home, or None
+        for methods whose false course heads can't be computed."""
+        heads = false_course_heads(self.stage, self.pn, self.leadcount)
+        return None if heads is None else falseness_signature(self.stage, heads)
 
     def __lt__(self, m: "Method") -> bool:
         assert isinstance(m, Method)
@@ -134,27 +386,211 @@ class Method:
         return self.sort_title < m.sort_title
 
 
-FILE_VERSION = 0x02
+FILE_VERSION = 0x03
 MAGIC_WORD = b"CCML"
-HEADER_STRUCT = struct.Struct("< 4s B B x B")
+HEADER_STRUCT = struct.Struct("< 4s B B B B")
 POINTERS_START = HEADER_STRUCT.size
+SECTION_COUNT_STRUCT = struct.Struct("< H")
+SECTION_STRUCT = struct.Struct("< 4s L L")
+MAX_POINTER_DEPTH = 4  # charset::MAX_SEARCH_POINTER_DEPTH
+
+FLAG_FRONT_CODED_TITLES = 0x01
+FLAG_POOLED_PN = 0x02
+FLAG_SYMMETRIC_PN = 0x04
+DEFAULT_FLAGS = FLAG_FRONT_CODED_TITLES | FLAG_POOLED_PN | FLAG_SYMMETRIC_PN
+
+INDEX_TAG = b"INDX"
+INDEX_KEY_WIDTH = 16
+INDEX_HEADER_STRUCT = struct.Struct("< L B 3x")
+INDEX_ENTRY_STRUCT = struct.Struct(f"< L {INDEX_KEY_WIDTH}s")
+
+TITLE_BLOCKS_TAG = b"TBLK"
+TITLE_BLOCK_LENGTH = 16  # methods per front-coded block
+
+PN_POOL_TAG = b"PNPL"
+
+
+class PnPool:
+    """Place notation shared between the methods of a file. A method takes
+    the longest prefix of its place notation which starts a pooled sequence,
+    so methods which only differ at the lead end share the rest of the lead."""
+
+    pn: list[int]
+    prefixes: dict[tuple[int, ...], int]
+
+    def __init__(self, methods: Iterable[Method], symmetric: bool) -> None:
+        self.pn = []
+        self.prefixes = {}
+        unique_pn = {tuple(m.get_stored_pn(symmetric)) for m in methods}
+        # longest first, so that shorter sequences can be found within them
+        for pn in sorted(unique_pn, key=lambda pn: (-len(pn), pn)):
+            _, count = self.lookup(pn)
+            if count * 2 < len(pn):  # not enough to share; add it
+                self.add(pn)
+
+    def add(self, pn: tuple[int, ...]) -> None:
+        start = len(self.pn)
+        self.pn.extend(pn)
+        for length in range(1, len(pn) + 1):
+            self.prefixes.setdefault(pn[:length], start)
+
+    def lookup(self, pn: Iterable[int]) -> tuple[int, int]:
+        """Index and length of the longest pooled prefix of pn."""
+        pn = tuple(pn)
+        for length in range(len(pn), 0, -1):
+            index = self.prefixes.get(pn[:length])
+            if index is not None:
+                return (index, length)
+        return (0, 0)
+
+    def dumps(self) -> bytes:
+        return struct.pack(f"< {len(self.pn)}H", *self.pn)
+
+
+TRIGRAM_TAG = b"TRGM"
+TRIGRAM_HEADER_STRUCT = struct.Struct("< L")
+TRIGRAM_ENTRY_STRUCT = struct.Struct("< 3s B L L")
+TRIGRAM_LIST_FRACTION = 4  # trigrams in more than this fraction of titles aren't listed
+
+
+def varint_dumps(value: int) -> bytes:
+    """Little-endian base-128, with the top bit set on all but the last byte."""
+    data = bytearray()
+    while value >= 0x80:
+        data.append(value & 0x7F | 0x80)
+        value >>= 7
+    data.append(value)
+    return bytes(data)
+
+
+class TrigramIndex:
+    """The ordinals of the methods whose search keys contain each trigram, so
+    that titles containing a search anywhere are found by intersecting the
+    lists of its trigrams. Trigrams in too many titles to narrow a search
+    (like those of the stage name) are marked present without a list."""
+
+    postings: dict[bytes, list[int]]
+    max_listed: int
+
+    def __init__(self, sorted_methods: list[Method]) -> None:
+        self.postings = {}
+        for ordinal, method in enumerate(sorted_methods):
+            key = method.sort_title.encode("ascii")
+            for trigram in {key[i : i + 3] for i in range(len(key) - 2)}:
+                self.postings.setdefault(trigram, []).append(ordinal)
+        self.max_listed = len(sorted_methods) // TRIGRAM_LIST_FRACTION
+
+    def dumps(self) -> bytes:
+        entries = [TRIGRAM_HEADER_STRUCT.pack(len(self.postings))]
+        lists = []
+        offset = 0
+        for trigram, ordinals in sorted(self.postings.items()):
+            listed = len(ordinals) <= self.max_listed
+            data = b""
+            if listed:  # gaps between ordinals, which are in order
+                data = b"".join(
+                    varint_dumps(ordinal - previous - 1)
+                    for previous, ordinal in zip([-1] + ordinals, ordinals)
+                )
+            entries.append(TRIGRAM_ENTRY_STRUCT.pack(trigram, listed, offset, len(ordinals)))
+            lists.append(data)
+            offset += len(data)
+        return b"".join(entries) + b"".join(lists)
+
+
+PN_HASH_INDEX_TAG = b"XPNH"
+LEAD_LENGTH_INDEX_TAG = b"XLEN"
+HUNT_BELLS_INDEX_TAG = b"XHNT"
+CLASS_INDEX_TAG = b"XCLS"
+FALSENESS_INDEX_TAG = b"XFLS"
+ATTRIBUTE_INDEX_HEADER_STRUCT = struct.Struct("< L")
+ATTRIBUTE_KEY_STRUCT = struct.Struct("< L L")
+# Secondary indexes, which find methods by something other than their title
+ATTRIBUTE_INDEXES: tuple[tuple[bytes, Callable[[Method], int | None]], ...] = (
+    (PN_HASH_INDEX_TAG, Method.get_pn_hash),
+    (LEAD_LENGTH_INDEX_TAG, lambda m: len(m.pn)),
+    (HUNT_BELLS_INDEX_TAG, lambda m: m.huntbells),
+    (CLASS_INDEX_TAG, Method.get_classification),
+    (FALSENESS_INDEX_TAG, Method.get_falseness_signature),
+)
+
+
+def attribute_index_dumps(keys: list[int | None], offsets: list[int]) -> bytes:
+    """Each distinct key in order, with the index of its first offset in the
+    table which follows, where the offsets of the methods with each key are
+    grouped in title order. Methods whose key is None are left out."""
+    groups: defaultdict[int, list[int]] = defaultdict(list)
+    for key, offset in zip(keys, offsets):
+        if key is not None:
+            groups[key].append(offset)
+    data = [ATTRIBUTE_INDEX_HEADER_STRUCT.pack(len(groups))]
+    table: list[int] = []
+    for key in sorted(groups):
+        data.append(ATTRIBUTE_KEY_STRUCT.pack(key, len(table)))
+        table.extend(groups[key])
+    data.append(struct.pack(f"< {len(table)}L", *table))
+    return b"".join(data)
 
 
 class MethodFile:
     stage: int
     pointerdepth: int
+    version: int
+    flags: int
     pointers: list[int]
+    bucket_ordinals: list[int]
+    method_offsets: list[int]
+    pn_pool: PnPool | None
+    trigram_index: bool
+    trigrams: TrigramIndex | None
+    secondary_indexes: bool
+    attribute_keys: list[list[int | None]] | None
 
-    def __init__(self, stage: int, pointerdepth: int) -> None:
+    def __init__(
+        self,
+        stage: int,
+        pointerdepth: int,
+        version: int = FILE_VERSION,
+        flags: int | None = None,
+        trigram_index: bool = True,
+        secondary_indexes: bool = True,
+    ) -> None:
+        assert version in (0x02, 0x03), f"Bad version {version}"
+        if flags is None:
+            flags = DEFAULT_FLAGS if version >= 0x03 else 0
+        assert version >= 0x03 or flags == 0, "Flags need v3"
         self.stage = stage
+        assert 0 <= pointerdepth <= MAX_POINTER_DEPTH, f"Bad pointer depth {pointerdepth}"
         self.pointerdepth = pointerdepth
+        self.version = version
+        self.flags = flags
         self.pointers = [0] * jump_layersize(pointerdepth)
+        self.bucket_ordinals = [0] * len(self.pointers)
+        self.method_offsets = []
+        self.pn_pool = None
+        self.trigram_index = trigram_index
+        self.trigrams = None
+        self.secondary_indexes = secondary_indexes
+        self.attribute_keys = None
+
+    @property
+    def front_coded(self) -> bool:
+        return bool(self.flags & FLAG_FRONT_CODED_TITLES)
+
+    @property
+    def pooled_pn(self) -> bool:
+        return bool(self.flags & FLAG_POOLED_PN)
+
+    @property
+    def symmetric_pn(self) -> bool:
+        return bool(self.flags & FLAG_SYMMETRIC_PN)
 
     def header_dumps(self) -> bytes:
         return HEADER_STRUCT.pack(
             MAGIC_WORD,
-            FILE_VERSION,
+            self.version,
             self.stage,
+            self.flags,  # padding in v2
             self.pointerdepth,
         )
 
@@ -174,31 +610,104 @@ class MethodFile:
             raise Exception
         return f.write(self.pointers_dumps())
 
+    def index_dumps(self, sorted_methods: list[Method]) -> bytes:
+        """Table of method offsets and key prefixes in sorted order, after
+        the ordinal of the first method in each jump pointer bucket."""
+        offsets = self.method_offsets or [0] * len(sorted_methods)
+        data = [
+            INDEX_HEADER_STRUCT.pack(len(sorted_methods), INDEX_KEY_WIDTH),
+            struct.pack(f"< {len(self.bucket_ordinals)}L", *self.bucket_ordinals),
+        ]
+        for offset, method in zip(offsets, sorted_methods):
+            key = method.sort_title.encode("ascii")[:INDEX_KEY_WIDTH]
+            data.append(INDEX_ENTRY_STRUCT.pack(offset, key))
+        return b"".join(data)
+
+    def title_blocks_dumps(self, sorted_methods: list[Method]) -> bytes:
+        """Offset of the first method of each front-coded block."""
+        offsets = self.method_offsets or [0] * len(sorted_methods)
+        block_offsets = offsets[::TITLE_BLOCK_LENGTH]
+        return struct.pack(f"< {len(block_offsets)}L", *block_offsets)
+
+    def get_sections(self, sorted_methods: list[Method]) -> list[tuple[bytes, bytes]]:
+        if self.version < 0x03:
+            return []
+        sections = [(INDEX_TAG, self.index_dumps(sorted_methods))]
+        if self.front_coded:
+            sections.append((TITLE_BLOCKS_TAG, self.title_blocks_dumps(sorted_methods)))
+        if self.pooled_pn:
+            if self.pn_pool is None:
+                self.pn_pool = PnPool(sorted_methods, self.symmetric_pn)
+            sections.append((PN_POOL_TAG, self.pn_pool.dumps()))
+        if self.trigram_index:
+            if self.trigrams is None:
+                self.trigrams = TrigramIndex(sorted_methods)
+            sections.append((TRIGRAM_TAG, self.trigrams.dumps()))
+        if self.secondary_indexes:
+            if self.attribute_keys is None:
+                self.attribute_keys = [
+                    [attribute(m) for m in sorted_methods] for _, attribute in ATTRIBUTE_INDEXES
+                ]
+            offsets = self.method_offsets or [0] * len(sorted_methods)
+            for (tag, _), keys in zip(ATTRIBUTE_INDEXES, self.attribute_keys):
+                sections.append((tag, attribute_index_dumps(keys, offsets)))
+        return sections
+
+    def sections_dumps(self, sections: list[tuple[bytes, bytes]]) -> bytes:
+        if self.version < 0x03:
+            return b""
+        directory = [SECTION_COUNT_STRUCT.pack(len(sections))]
+        start = (
+            self.after_pointers()
+            + SECTION_COUNT_STRUCT.size
+            + SECTION_STRUCT.size * len(sections)
+        )
+        for tag, data in sections:
+            directory.append(SECTION_STRUCT.pack(tag, start, len(data)))
+            start += len(data)
+        return b"".join(directory) + b"".join(data for _, data in sections)
+
+    def sections_dump(self, f: IO[bytes], sorted_methods: list[Method]) -> int:
+        if f.seek(self.after_pointers()) != self.after_pointers():
+            raise Exception
+        return f.write(self.sections_dumps(self.get_sections(sorted_methods)))
+
     def get_title_sort_checks(self) -> Generator[tuple[int, str], None, None]:
         yield from enumerate(get_title_cats(self.pointerdepth))
         yield (len(self.pointers), "\U0010ffff")
 
     def dump_methods(self, f: IO[bytes], sorted_methods: list[Method]) -> int:
-        if f.seek(self.after_pointers()) != self.after_pointers():
-            raise Exception
         f.truncate()
 
         title_sort_it = self.get_title_sort_checks()
         next_title_sort = next(title_sort_it)
 
         length_written = 0
+        self.method_offsets = []
 
-        for method in sorted_methods:
+        for ordinal, method in enumerate(sorted_methods):
             while next_title_sort[1] < method.sort_title:
                 self.pointers[next_title_sort[0]] = f.tell()
+                self.bucket_ordinals[next_title_sort[0]] = ordinal
                 next_title_sort = next(title_sort_it)
 
             assert method.stage == self.stage
-            length_written += method.dump(f)
+            self.method_offsets.append(f.tell())
+            if not self.front_coded:
+                prev_title = None
+            elif ordinal % TITLE_BLOCK_LENGTH == 0:
+                prev_title = b""
+            else:
+                prev_title = sorted_methods[ordinal - 1].raw_title
+            pool_ref = None
+            if self.pn_pool is not None:
+                pool_ref = self.pn_pool.lookup(method.get_stored_pn(self.symmetric_pn))
+            length_written += method.dump(f, prev_title, pool_ref, self.symmetric_pn)
 
         # Make remaining pointers point to EOF here
         while next_title_sort[0] < len(self.pointers):
             self.pointers[next_title_sort[0]] = f.tell()
+            self.bucket_ordinals[next_title_sort[0]] = len(sorted_methods)
             next_title_sort = next(title_sort_it)
 
         return length_written
@@ -206,13 +715,49 @@ class MethodFile:
     def dump(self, f: IO[bytes], sorted_methods: list[Method]) -> int:
         length = self.header_dump(f)
         length += self.pointers_dump(f)
+        sections_length = self.sections_dump(f, sorted_methods)
+        length += sections_length
         length += self.dump_methods(f, sorted_methods)
         assert f.tell() == length
-        self.pointers_dump(f)  # rewrite after pointers updated in dump_methods
+        # rewrite after pointers and offsets updated in dump_methods
+        self.pointers_dump(f)
+        assert self.sections_dump(f, sorted_methods) == sections_length
         f.seek(length)
         return length
 
 
+LIBRARY_MAGIC_WORD = b"CCLB"
+LIBRARY_VERSION = 0x01
+LIBRARY_HEADER_STRUCT = struct.Struct("< 4s B B 2x")
+LIBRARY_ENTRY_STRUCT = struct.Struct("< B 3x L L")
+
+
+class MethodLibrary:
+    """A single file holding the method file of each stage, so that the app
+    can switch stage without opening another file."""
+
+    files: dict[int, bytes]
+
+    def __init__(self) -> None:
+        self.files = {}
+
+    def add(self, stage: int, data: bytes) -> None:
+        assert stage not in self.files
+        self.files[stage] = data
+
+    def dump(self, f: IO[bytes]) -> int:
+        stages = sorted(self.files)
+        length = f.write(LIBRARY_HEADER_STRUCT.pack(LIBRARY_MAGIC_WORD, LIBRARY_VERSION, len(stages)))
+        start = length + LIBRARY_ENTRY_STRUCT.size * len(stages)
+        for stage in stages:
+            length += f.write(LIBRARY_ENTRY_STRUCT.pack(stage, start, len(self.files[stage])))
+            start += len(self.files[stage])
+        for stage in stages:
+            length += f.write(self.files[stage])
+        assert length == start
+        return length
+
+
 SCHEMA = "http://www.cccbr.org.uk/methods/schemas/2007/05/methods"
 TSCHEMA = "{" + SCHEMA + "}"
 
@@ -261,6 +806,7 @@ def read_method(element: Any) -> Method:
         pn=convert_pn(notation),
         leadcount=leadcount,
         huntbells=huntbells,
+        symmetry=get_pn_symmetry(notation),
     )
 
 
@@ -469,6 +1015,7 @@ DEFAULT_LIB = {
     "Single Oxford Bob Minor",
     "Double Oxford Bob Minor",
 }
+OUT_LIBRARY_FILE = "methods/library.ccml"
 OUT_FILE = "methods/methods-{}.ccml"
 OUT_FILE_CHARS = (
     None,
@@ -491,24 +1038,116 @@ OUT_FILE_CHARS = (
 )
 
 if __name__ == "__main__":
-    assert len(sys.argv) == 2, "Takes one argument: path to CCCBR_methods.xml.zip"
-    FILENAME = sys.argv[1]
+    parser = argparse.ArgumentParser()
+    parser.add_argument("filename", help="path to CCCBR_methods.xml.zip")
+    parser.add_argument(
+        "--file-version",
+        type=lambda v: int(v, 0),
+        default=FILE_VERSION,
+        help=f"CCML version to write (2 or 3; default {FILE_VERSION})",
+    )
+    parser.add_argument(
+        "--plain-titles",
+        action="store_true",
+        help="store every title in full, instead of front-coding them (v3)",
+    )
+    parser.add_argument(
+        "--no-pn-pool",
+        action="store_true",
+        help="store place notation in each method, instead of in a shared pool (v3)",
+    )
+    parser.add_argument(
+        "--full-leads",
+        action="store_true",
+        help="store the whole lead of symmetric methods, instead of half of it (v3)",
+    )
+    parser.add_argument(
+        "--no-trigrams",
+        action="store_true",
+        help="leave out the trigram index for searching within titles (v3)",
+    )
+    parser.add_argument(
+        "--no-secondary-indexes",
+        action="store_true",
+        help="leave out the indexes by place notation, lead length, hunt bells and class (v3)",
+    )
+    parser.add_argument(
+        "--per-stage-files",
+        action="store_true",
+        help=f"write a file per stage, instead of {OUT_LIBRARY_FILE}",
+    )
+    parser.add_argument(
+        "--size-report",
+        action="store_true",
+        help="compare the size of each file against v2 and without the pool",
+    )
+    args = parser.parse_args()
+    flags = DEFAULT_FLAGS if args.file_version >= 0x03 else 0
+    if args.plain_titles:
+        flags &= ~FLAG_FRONT_CODED_TITLES
+    if args.no_pn_pool:
+        flags &= ~FLAG_POOLED_PN
+    if args.full_leads:
+        flags &= ~FLAG_SYMMETRIC_PN
+    FILENAME = args.filename
 
     mfilter = StageFilter(2, 16)
     # mfilter &= TitleFilter(DEFAULT_LIB)
     mit = read_methods_from_zip(FILENAME, mfilter)
     ms = group_and_sort_methods(mit)
+    library = MethodLibrary()
     for stage, methods in sorted(ms.items(), key=lambda t: t[0]):
-        out_file = OUT_FILE.format(OUT_FILE_CHARS[stage])
-        print(f"{stage}: Writing to {out_file}")
+        if args.per_stage_files:
+            out_file = OUT_FILE.format(OUT_FILE_CHARS[stage])
+            print(f"{stage}: Writing to {out_file}")
 
         # aim for an average of 10 methods per bucket
         # (likely to be a lot more for some letters)
         float_pointerdepth = log(len(methods) / 10.0, len(JUMPCHARS))
-        pointerdepth = max(int(float_pointerdepth), 0)
+        pointerdepth = min(max(int(float_pointerdepth), 0), MAX_POINTER_DEPTH)
         # pointerdepth = min(pointerdepth, 1)
         print(f"{stage}: Using depth {pointerdepth}")
 
-        with open(out_file, "wb") as f:
-            MethodFile(stage, pointerdepth).dump(f, methods)
+        data = io.BytesIO()
+        length = MethodFile(
+            stage,
+            pointerdepth,
+            args.file_version,
+            flags,
+            not args.no_trigrams,
+            not args.no_secondary_indexes,
+        ).dump(data, methods)
+        if args.per_stage_files:
+            with open(out_file, "wb") as f:
+                f.write(data.getvalue())
+        else:
+            library.add(stage, data.getvalue())
         print(f"Written {len(methods)} methods for {stage} bells.")
+
+        if args.size_report:
+            v2_length = MethodFile(stage, pointerdepth, 0x02).dump(io.BytesIO(), methods)
+            unpooled_length = MethodFile(
+                stage,
+                pointerdepth,
+                args.file_version,
+                flags & ~FLAG_POOLED_PN,
+                not args.no_trigrams,
+                not args.no_secondary_indexes,
+            ).dump(io.BytesIO(), methods)
+            untrigrammed_length = MethodFile(
+                stage, pointerdepth, args.file_version, flags, False, not args.no_secondary_indexes
+            ).dump(io.BytesIO(), methods)
+            unindexed_length = MethodFile(
+                stage, pointerdepth, args.file_version, flags, not args.no_trigrams, False
+            ).dump(io.BytesIO(), methods)
+            print(
+                f"{stage}: {v2_length} bytes as v2, {unpooled_length} unpooled,"
+                f" {untrigrammed_length} without trigrams,"
+                f" {unindexed_length} without secondary indexes,"
+                f" {length} written ({length / v2_length:.1%} of v2)"
+            )
+
+    if not args.per_stage_files:
+        with open(OUT_LIBRARY_FILE, "wb") as f:
+            length = library.dump(f)
+        print(f"Written {len(library.files)} stages to {OUT_LIBRARY_FILE} ({length} bytes).")
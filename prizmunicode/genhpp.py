@@ -8,14 +8,19 @@ from .searchmap import (
     JUMPCHARS,
     SORT_ASCII_PTR_MAP,
     SORT_BYTE_MAP,
+    jump_layersize,
 )
 
 __all__ = [
+    "create_cpp_searchtables",
     "create_cpp_searchconvert",
+    "create_cpp_searchconvert_switch",
     "create_cpp_mbstartcheck",
+    "create_cpp_jumpoffsets",
     "main",
 ]
 
+MAX_SEARCH_POINTER_DEPTH = 4  # charset::MAX_SEARCH_POINTER_DEPTH
 INVALID_C_CHAR = set(map(ord, "'\\"))
 
 
@@ -61,7 +66,9 @@ CPP_SWITCHED_BOTTOM = """\
 """
 
 
-def create_cpp_searchconvert(fname: str) -> str:
+def create_cpp_searchconvert_switch(fname: str) -> str:
+    """ReadSearchChar as a switch over each byte, as it was before the tables;
+    only used to benchmark the tables against it."""
     returnvals: defaultdict[str, set[int]] = defaultdict(set)
     groups: dict[int, dict[int, str]] = {}
     for i1, c1 in SORT_BYTE_MAP.items():
@@ -108,52 +115,105 @@ def create_cpp_searchconvert(fname: str) -> str:
     return "\n".join(elements)
 
 
-def create_cpp_searchptrconvert(fname: str) -> str:
-    returnvals: defaultdict[int, set[int]] = defaultdict(set)
-    for i1, c1 in SORT_ASCII_PTR_MAP.items():
-        returnvals[c1].add(i1)
+CPP_TABLE_VALUES_PER_LINE = 16
 
-    elements: list[str] = [
-        CPP_SWITCHED_TOP.format(fname=fname, ret="SearchIndex", null="-1")
-    ]
-    for c in sorted(returnvals):
-        iset = returnvals[c]
-        if not iset:
-            continue
-        if c == CPP_SEARCH_DEFAULT:  # covered by default case
+
+def format_cpp_table_values(values: list[str], indent: str) -> str:
+    return ",\n".join(
+        indent + ", ".join(values[i : i + CPP_TABLE_VALUES_PER_LINE])
+        for i in range(0, len(values), CPP_TABLE_VALUES_PER_LINE)
+    )
+
+
+def get_lead_bytes() -> list[int]:
+    return sorted(i for i, c in SORT_BYTE_MAP.items() if isinstance(c, dict))
+
+
+def create_cpp_searchtables() -> str:
+    lead_bytes = get_lead_bytes()
+    assert len(lead_bytes) < 0x100
+
+    chars = [CPP_DEFAULT_C_CHAR] * 0x100
+    chars[0] = "'\\0'"
+    rows = ["0"] * 0x100
+    trails: list[list[str]] = []
+    for i1, c1 in SORT_BYTE_MAP.items():
+        if isinstance(c1, dict):
             continue
-        for i in sorted(iset):
-            elements.append(CPP_CASE_LINE.format(src=get_c_char(i, True)))
-        elements.append(CPP_CASE_RETURN.format(dest=c))
+        chars[i1] = get_c_char(ord(c1), True)
+    for row, i1 in enumerate(lead_bytes):
+        rows[i1] = str(row + 1)
+        trail = [CPP_DEFAULT_C_CHAR] * 0x100
+        c1 = SORT_BYTE_MAP[i1]
+        assert isinstance(c1, dict)
+        for i2, c2 in c1.items():
+            trail[i2] = get_c_char(ord(c2), True)
+        trails.append(trail)
 
-    elements.append(CPP_SWITCHED_BOTTOM.format(default=CPP_SEARCH_DEFAULT))
-    return "\n".join(elements)
+    ptrs = [str(CPP_SEARCH_DEFAULT)] * 0x100
+    for i1, c1 in SORT_ASCII_PTR_MAP.items():
+        ptrs[i1] = str(c1)
 
+    trail_rows = ",\n".join(
+        "    {\n" + format_cpp_table_values(trail, "        ") + "\n    }"
+        for trail in trails
+    )
+    return f"""\
+// Search character of each byte, or of each byte after a lead byte in its row of searchTrailChars
+constexpr NonMBChar searchChars[0x100] = {{
+{format_cpp_table_values(chars, "    ")}
+}};
+// Row of searchTrailChars plus one for each lead byte, or 0 for any other byte
+constexpr unsigned char searchLeadRows[0x100] = {{
+{format_cpp_table_values(rows, "    ")}
+}};
+constexpr NonMBChar searchTrailChars[{len(trails)}][0x100] = {{
+{trail_rows}
+}};
+// Jump character index of each byte
+constexpr unsigned char searchPointerIndexes[0x100] = {{
+{format_cpp_table_values(ptrs, "    ")}
+}};
+"""
 
-CPP_MB_TOP = """\
-bool {fname}(const MBChar c)
+
+def create_cpp_searchconvert(fname: str) -> str:
+    return f"""\
+NonMBChar {fname}(const MBChar *&c)
 {{
-    switch (c)
-    {{"""
-CPP_MB_BOTTOM = """\
-        default:
-            return false;
-    }
-}
+    const unsigned char b = *c;
+    if (b == '\\0')
+        return '\\0';
+    c++;
+    const unsigned char row = searchLeadRows[b];
+    if (row == 0)
+        return searchChars[b];
+    const unsigned char trail = *c;
+    if (trail != '\\0') // don't read past the end of a string cut short after a lead byte
+        c++;
+    return searchTrailChars[row - 1][trail];
+}}
+"""
+
+
+def create_cpp_searchptrconvert(fname: str) -> str:
+    return f"""\
+SearchIndex {fname}(const MBChar *&c)
+{{
+    if (*c == '\\0')
+        return -1;
+    return searchPointerIndexes[(unsigned char)*c++];
+}}
 """
 
 
 def create_cpp_mbstartcheck(fname: str) -> str:
-    elements: list[str] = [CPP_MB_TOP.format(fname=fname)]
-    gen_lines = False
-    for i in sorted(BYTE_MAP):
-        if isinstance(BYTE_MAP[i], dict):
-            gen_lines = True
-            elements.append(CPP_CASE_LINE.format(src=get_c_char(i)))
-    if gen_lines:
-        elements.append(CPP_CASE_RETURN.format(dest="true"))
-    elements.append(CPP_MB_BOTTOM)
-    return "\n".join(elements)
+    return f"""\
+bool {fname}(const MBChar c)
+{{
+    return searchLeadRows[(unsigned char)c] != 0;
+}}
+"""
 
 
 def create_cpp_jumpcharcount(cname: str) -> str:
@@ -162,6 +222,25 @@ const int {cname} = {len(JUMPCHARS)};
 """
 
 
+def create_cpp_jumpoffsets(cname: str) -> str:
+    rows = []
+    for depth in range(MAX_SEARCH_POINTER_DEPTH):
+        offsets = []
+        offset = 0
+        for j in JUMPCHARS:
+            offsets.append(str(offset))
+            offset += 1 if j.stop else jump_layersize(depth)
+        rows.append("    {\n" + format_cpp_table_values(offsets, "        ") + "\n    }")
+    rows_text = ",\n".join(rows)
+    return f"""\
+// Offset of the pointer for each jump character within a layer of the
+// pointer table, by the depth of the layers below it
+constexpr int {cname}[MAX_SEARCH_POINTER_DEPTH][jumpCharCount] = {{
+{rows_text}
+}};
+"""
+
+
 def create_cpp_jumplayersize(fname: str) -> str:
     return f"""\
 int {fname}(const int depth)
@@ -201,19 +280,25 @@ def main(argv: list[str]) -> None:
             f.write(
                 "\n".join(
                     [
+                        create_cpp_searchtables(),
                         create_cpp_searchconvert("ReadSearchChar"),
                         create_cpp_searchptrconvert("ReadSearchCharPtr"),
-                        # not required - syscall MB_IsLead has same function
-                        # create_cpp_mbstartcheck(...),
+                        # syscall MB_IsLead has same function; used by host builds
+                        create_cpp_mbstartcheck("IsLeadByte"),
                         create_cpp_jumpcharcount("jumpCharCount"),
+                        create_cpp_jumpoffsets("jumpOffsets"),
                         create_cpp_jumplayersize("GetJumpDepth"),
                         create_cpp_isjumpstop("IsSearchStop"),
                     ]
                 )
             )
+    elif len(argv) == 3 and argv[1] == "create_switch_hpp":
+        with open(argv[2], "w") as f:
+            f.write(create_cpp_searchconvert_switch("ReadSearchCharSwitch"))
     else:
         print(f"Usage: {argv[0]} SUBCMD ...")
         print("    create_hpp PATH")
+        print("    create_switch_hpp PATH")
 
 
 if __name__ == "__main__":
@@ -1,10 +1,17 @@
+#ifdef __sh__
 #include <fxcg/system.h>
+#endif
 #include "charset.hpp"
 
 namespace charset
 {
 #include "gen.hpp"
 
+#ifndef __sh__
+    // No syscall on the host; use the generated lead byte check instead
+    inline bool MB_IsLead(const MBChar c) { return IsLeadByte(c); }
+#endif
+
     CharCount CopyString(const MBChar *src, MBChar *dest, int max_char_count, int max_byte_count, bool force_null)
     {
         CharCount count = {0, 0};
@@ -36,25 +43,23 @@ namespace charset
 
     int GetSearchPointerIndex(const NonMBChar *searchstring, int pointerdepth)
     {
+        if (pointerdepth > MAX_SEARCH_POINTER_DEPTH)
+            pointerdepth = MAX_SEARCH_POINTER_DEPTH;
         int pindex = 0;
-        for (int kindex = 0; kindex < pointerdepth; kindex++)
+        for (int depth = pointerdepth - 1; depth >= 0; depth--)
         {
             const SearchIndex k = ReadSearchCharPtr(searchstring);
             if (k < 0) // end of string
                 return pindex;
-            const int depth = pointerdepth - kindex - 1;
-            const int layersize = GetJumpDepth(depth);
-            for (int j = 0; j < jumpCharCount; j++)
-            {
-                if (k == j)
-                {
-                    if (IsSearchStop(k))
-                        return pindex;
-                    break;
-                }
-                pindex += IsSearchStop(j) ? 1 : layersize;
-            }
+            pindex += jumpOffsets[depth][k];
+            if (IsSearchStop(k))
+                return pindex;
         }
         return pindex;
     }
+
+    int GetSearchPointerCount(int pointerdepth)
+    {
+        return GetJumpDepth(pointerdepth);
+    }
 }
@@ -1,6 +1,8 @@
 #ifndef CHARSET_HPP
 #define CHARSET_HPP
 
+#include <string.h>
+
 namespace charset
 {
     typedef char MBChar;
@@ -73,7 +75,76 @@ namespace charset
         }
     }
 
+    // Normalise searchstring into up to maxlength characters of dest, NUL-terminated,
+    // so it is only read once however many titles it is compared against. Returns its length.
+    inline int NormaliseSearch(const NonMBChar *searchstring, NonMBChar *dest, int maxlength)
+    {
+        int length = 0;
+        while (length < maxlength && (dest[length] = ReadSearchChar(searchstring)) != '\0')
+            length++;
+        dest[length] = '\0';
+        return length;
+    }
+
+    // As CompareSearch, for a search normalised by NormaliseSearch.
+    inline CompareResult CompareNormalisedSearch(const NonMBChar *search, const MBChar *text)
+    {
+        if (search == nullptr || text == nullptr)
+            return Err;
+        while (*search != '\0')
+        {
+            NonMBChar s = *search++, t = ReadSearchChar(text);
+            if (t == '\0' || t < s)
+                return BeforeKey;
+            else if (t > s)
+                return AfterKey;
+        }
+        return Contained;
+    }
+
+    // As CompareSearch, for the first length characters of a normalised search against
+    // a key which is already normalised and NUL-padded to at least length bytes.
+    inline CompareResult CompareSearchKey(const NonMBChar *search, int length, const NonMBChar *key)
+    {
+        const int order = memcmp(key, search, length);
+        return order < 0 ? BeforeKey : order > 0 ? AfterKey : Contained;
+    }
+
+    // Order of two titles in a method file, by their normalised characters: negative, zero or positive.
+    inline int CompareTitles(const MBChar *a, const MBChar *b)
+    {
+        while (true)
+        {
+            NonMBChar x = ReadSearchChar(a), y = ReadSearchChar(b);
+            if (x != y)
+                return x < y ? -1 : 1;
+            if (x == '\0')
+                return 0;
+        }
+    }
+
+    // Whether searchkey matches text starting at any of its characters.
+    inline bool ContainsSearch(const NonMBChar *searchkey, const MBChar *text)
+    {
+        if (searchkey == nullptr || text == nullptr)
+            return false;
+        while (true)
+        {
+            if (CompareSearch(searchkey, text) == Contained)
+                return true;
+            if (*text == '\0')
+                return false;
+            ReadSearchChar(text); // move to the next character
+        }
+    }
+
+    // Deepest jump pointer table a file may have; depth 4 is already 570,000 pointers.
+    const int MAX_SEARCH_POINTER_DEPTH = 4;
+
+    // Index of the jump pointer for searchstring; pointerdepth is at most MAX_SEARCH_POINTER_DEPTH.
     int GetSearchPointerIndex(const NonMBChar *searchstring, int pointerdepth);
+    // Number of jump pointers in a file with the given pointer depth.
+    int GetSearchPointerCount(int pointerdepth);
 }
 
 #endif
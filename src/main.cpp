@@ -7,6 +7,8 @@
 #include "charset/charset.cpp"
 #include "ringing/method.cpp"
 #include "ringing/row.cpp"
+#include "ringing/packedrow.cpp"
+#include "ringing/course.cpp"
 #include "ringing/filereader.cpp"
 #include "vram.cpp.hpp"
 #include "test_methods.hpp"
@@ -3,6 +3,12 @@
 #include "ringing/row.hpp"
 #include "ringing/filereader.hpp"
 
+// Holds every stage; used in preference to the file for each stage.
+const char LIBRARY_FILE[] = "\\\\fls0\\methods\\library.ccml";
+unsigned short LIBRARY_FILE_W[sizeof(LIBRARY_FILE)];
+// Set once the library has failed to open, so that later stage switches don't try it again.
+bool library_missing = false;
+
 char METHOD_FILE[] = "\\\\fls0\\methods\\methods-X.ccml";
 char *const METHOD_FILE_STAGE_CHAR = METHOD_FILE + 23;
 unsigned short METHOD_FILE_W[sizeof(METHOD_FILE)];
@@ -18,6 +24,7 @@ bool PrepareLoadMethodFile(int stage)
     *METHOD_FILE_STAGE_CHAR = METHOD_FILE_STAGE_CHARS[stage];
 
     Bfile_StrToName_ncpy(METHOD_FILE_W, METHOD_FILE, sizeof(METHOD_FILE));
+    Bfile_StrToName_ncpy(LIBRARY_FILE_W, LIBRARY_FILE, sizeof(LIBRARY_FILE));
     return true;
 }
 
@@ -25,6 +32,14 @@ bool LoadMethodFile(ringing::FileReader &mf, int stage)
 {
     if (!PrepareLoadMethodFile(stage))
         return false;
+    // switching stage within an open library only moves the reader to another part of it
+    if (mf.IsLibrary() || (!library_missing && mf.TryOpen(LIBRARY_FILE_W)))
+    {
+        if (mf.SelectStage(stage))
+            return true;
+    }
+    else
+        library_missing = true;
     mf.Close();
     if (!mf.TryOpen(METHOD_FILE_W))
         return false;
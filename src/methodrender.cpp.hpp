@@ -2,6 +2,7 @@
 #include "charset/charset.hpp"
 #include "ringing/row.hpp"
 #include "ringing/method.hpp"
+#include "ringing/course.hpp"
 #include "vram.hpp"
 
 namespace methodrender
@@ -161,11 +162,16 @@ namespace methodrender
         PrintMiniGlyph(x, sy, glyph, 0x42, width, 0, 0, 0, 0, colour, 0, 0);
     }
 
-    void PrintRow(const int cx, int y, const int stage, const ringing::Bell row[], const LineStyle styles[])
+    // Stage of the render kernels for stages above ringing::MAX_SPECIALISED_STAGE, which loop to the stage of each row.
+    const int ANY_STAGE = -1;
+
+    template <int Stage>
+    void PrintRow(const int cx, int y, const ringing::Row &row, const LineStyle styles[])
     {
+        const int stage = Stage == ANY_STAGE ? row.stage : Stage;
         for (int i = stage - 1; i >= 0; i--)
         {
-            auto bell = row[i];
+            auto bell = row.row[i];
             LineStyle style = styles[bell];
 
             if (style.GetTextDisplay())
@@ -175,11 +181,13 @@ namespace methodrender
         }
     }
 
-    void PrintBackLines(const int ex, int y, const int stage, const ringing::Bell row[], ringing::ChangeDirection backdirections[], const LineStyle styles[])
+    template <int Stage>
+    void PrintBackLines(const int ex, int y, const ringing::Row &row, const ringing::ChangeDirection backdirections[], const LineStyle styles[])
     {
+        const int stage = Stage == ANY_STAGE ? row.stage : Stage;
         for (int i = stage - 1; i >= 0; i--)
         {
-            auto bell = row[i];
+            auto bell = row.row[i];
             auto dir = backdirections[i];
             LineStyle style = styles[bell];
             auto lineThickness = style.GetLineThickness();
@@ -191,18 +199,41 @@ namespace methodrender
         }
     }
 
-    void PrintFirstRow(const int &cx, const int sy, const ringing::Row &row, const LineStyle styles[])
+    // PrintRow and PrintBackLines for a stage chosen at runtime, looked up once per render.
+    struct RenderKernels
+    {
+        void (*printrow)(int cx, int y, const ringing::Row &row, const LineStyle styles[]);
+        void (*printbacklines)(int ex, int y, const ringing::Row &row, const ringing::ChangeDirection backdirections[], const LineStyle styles[]);
+    };
+
+#define STAGE_RENDER_KERNELS(stage) \
+    {&PrintRow<stage>, &PrintBackLines<stage>}
+
+    const RenderKernels RENDER_KERNELS[ringing::MAX_SPECIALISED_STAGE + 1] = {
+        STAGE_RENDER_KERNELS(0), STAGE_RENDER_KERNELS(1), STAGE_RENDER_KERNELS(2), STAGE_RENDER_KERNELS(3),
+        STAGE_RENDER_KERNELS(4), STAGE_RENDER_KERNELS(5), STAGE_RENDER_KERNELS(6), STAGE_RENDER_KERNELS(7),
+        STAGE_RENDER_KERNELS(8), STAGE_RENDER_KERNELS(9), STAGE_RENDER_KERNELS(10), STAGE_RENDER_KERNELS(11),
+        STAGE_RENDER_KERNELS(12)};
+    static_assert(ringing::MAX_SPECIALISED_STAGE == 12, "RENDER_KERNELS must have an entry for every specialised stage");
+    const RenderKernels GENERIC_RENDER_KERNELS = STAGE_RENDER_KERNELS(ANY_STAGE);
+
+#undef STAGE_RENDER_KERNELS
+
+    const RenderKernels &GetRenderKernels(const int stage)
     {
-        PrintRow(cx, sy, row.stage, row.row, styles);
+        if (stage < 0 || stage > ringing::MAX_BELLS)
+            return RENDER_KERNELS[0];
+        if (stage > ringing::MAX_SPECIALISED_STAGE)
+            return GENERIC_RENDER_KERNELS;
+        return RENDER_KERNELS[stage];
     }
 
-    void UpdateAndPrintPn(int &cx, const int sy, ringing::Row &row, const ringing::PlaceNotation pn, const LineStyle styles[])
+    void UpdateAndPrintChange(int &cx, const int sy, ringing::Row &row, const ringing::Change &change, const ringing::RowKernels &rowkernels, const RenderKernels &renderkernels, const LineStyle styles[])
     {
-        ringing::ChangeDirection backdirections[row.stage];
-        row.ApplyPn(pn, nullptr, backdirections);
+        rowkernels.applycompiled(row, change);
         cx += RowWidth;
-        PrintRow(cx, sy, row.stage, row.row, styles);
-        PrintBackLines(cx, sy, row.stage, row.row, backdirections, styles);
+        renderkernels.printrow(cx, sy, row, styles);
+        renderkernels.printbacklines(cx, sy, row, change.backdirections, styles);
     }
 
     void CreateStyles(const ringing::Method &method, LineStyle *styles)
@@ -262,41 +293,93 @@ namespace methodrender
     }
 
     // Render the method. Returns true if the end of the method was reached.
-    bool PrintMethod(int &cx, const int sy, const ringing::Method &method, const LineStyle *const styles)
+    bool PrintMethod(int &cx, const int sy, const ringing::CompiledMethod &method, const LineStyle *const styles)
     {
         // if (cx - RowWidth / 2 >= LCD_WIDTH_PX ||
         //     sy >= LCD_HEIGHT_PX || sy + RowHeight * method.stage < 0)
         //     return false;
 
-        // TODO: Speed up by starting with named leadheads?
+        if (!method.IsValid())
+            return true;
+
+        const ringing::RowKernels &rowkernels = *method.kernels;
+        const RenderKernels &renderkernels = GetRenderKernels(method.stage);
 
         ringing::Row row = ringing::Row::Rounds(method.stage);
         // Row is visible if the right edge is past the left of the screen
         if (cx + RowWidth / 2 >= 0)
-            PrintFirstRow(cx, sy, row, styles);
+            renderkernels.printrow(cx, sy, row, styles);
+
+        // Jump straight to the lead containing the first visible row
+        const int hidden = -(cx + RowWidth + RowWidth / 2);
+        if (hidden > 0)
+        {
+            const int lead = (hidden + RowWidth - 1) / RowWidth / method.leadlength;
+            if (lead >= method.leadcount)
+            {
+                cx += RowWidth * method.PlainCourseLength();
+                return true;
+            }
+            if (lead > 0)
+            {
+                row = method.LeadHead(lead);
+                cx += RowWidth * method.leadlength * lead;
+            }
+        }
+
         int pn_i = 0;
         // Next row is invisible if its right edge is not past the left of the screen
         // Need to consider next one due to line drawing.
         while (cx + RowWidth + RowWidth / 2 < 0)
         {
-            row.ApplyPn(method.pn[pn_i++]);
+            rowkernels.applycompiled(row, method.GetChange(pn_i++));
             cx += RowWidth;
             pn_i %= method.leadlength;
 
-            if (pn_i == 0 && row.IsRounds())
+            if (pn_i == 0 && rowkernels.isrounds(row))
                 return true;
         }
 
         // Row is visible if left edge isn't past the right of the screen
         while (cx - RowWidth / 2 < LCD_WIDTH_PX)
         {
-            UpdateAndPrintPn(cx, sy, row, method.pn[pn_i++], styles);
+            UpdateAndPrintChange(cx, sy, row, method.GetChange(pn_i++), rowkernels, renderkernels, styles);
             pn_i %= method.leadlength;
 
-            if (pn_i == 0 && row.IsRounds())
+            if (pn_i == 0 && rowkernels.isrounds(row))
                 return true;
         }
 
         return false;
     }
+
+    // Render a cached course. Returns true if the end of the course was reached.
+    bool PrintCourse(int &cx, const int sy, const ringing::CourseCache &course, const LineStyle *const styles)
+    {
+        // Skip straight to the first row whose right edge is past the left of the screen
+        int index = 0;
+        const int hidden = -(cx + RowWidth / 2);
+        if (hidden > 0)
+            index = (hidden + RowWidth - 1) / RowWidth;
+        if (index >= course.RowCount())
+            return true;
+        cx += RowWidth * index;
+
+        const RenderKernels &renderkernels = GetRenderKernels(course.Stage());
+
+        // Row is visible if left edge isn't past the right of the screen
+        while (cx - RowWidth / 2 < LCD_WIDTH_PX)
+        {
+            const ringing::Row row = course.GetRow(index);
+            renderkernels.printrow(cx, sy, row, styles);
+            if (index > 0)
+                renderkernels.printbacklines(cx, sy, row, course.GetBackDirections(index), styles);
+
+            if (++index >= course.RowCount())
+                return true;
+            cx += RowWidth;
+        }
+
+        return false;
+    }
 }
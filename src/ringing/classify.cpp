@@ -0,0 +1,119 @@
+#include "row.hpp"
+#include "method.hpp"
+#include "classify.hpp"
+
+namespace ringing
+{
+    inline int GetPlace(const Row &row, const Bell bell)
+    {
+        for (int i = 0; i < row.stage; i++)
+            if (row.row[i] == bell)
+                return i;
+        return -1;
+    }
+
+    MethodClass ClassifyHuntPath(const Method &method, const int path[], bool &little)
+    {
+        const int stage = method.stage;
+        int counts[MAX_BELLS] = {0};
+        int minplace = stage, maxplace = -1;
+        for (int i = 0; i < method.leadlength; i++)
+        {
+            counts[path[i]]++;
+            if (path[i] < minplace)
+                minplace = path[i];
+            if (path[i] > maxplace)
+                maxplace = path[i];
+        }
+        little = minplace > 0 || maxplace < stage - 1;
+
+        bool allsame = true, alleven = true;
+        for (int place = minplace; place <= maxplace; place++)
+        {
+            if (counts[place] != counts[minplace])
+                allsame = false;
+            if (counts[place] == 0 || counts[place] % 2 != 0)
+                alleven = false;
+        }
+        if (!alleven)
+            return Hybrid;
+        if (!allsame)
+            return Alliance;
+        if (counts[minplace] == 2)
+            return Plain;
+
+        // Treble dodging: dodges in pairs of places, only lying still at the lead and the back
+        if ((maxplace - minplace) % 2 == 0)
+            return TreblePlace;
+        int crosssections = 0, internalplaces = 0;
+        const BellBitmask internal = ((1 << stage) - 1) & ~(1 << 0) & ~(1 << (stage - 1));
+        for (int i = 0; i < method.leadlength; i++)
+        {
+            const int from = path[i], to = path[(i + 1) % method.leadlength];
+            if (from == to)
+            {
+                if (from != minplace && from != maxplace)
+                    return TreblePlace;
+                continue;
+            }
+            // Moving between pairs of dodging places
+            const int lower = from < to ? from : to;
+            if ((lower - minplace) % 2 == 1)
+            {
+                crosssections++;
+                if ((method.pn[i] & internal) != 0)
+                    internalplaces++;
+            }
+        }
+        if (internalplaces == 0)
+            return TrebleBob;
+        if (internalplaces == crosssections)
+            return Surprise;
+        return Delight;
+    }
+
+    bool Classify(const Method &method, Classification &classification)
+    {
+        if (method.stage <= 0 || method.stage > MAX_BELLS)
+            return false;
+        if (method.leadlength <= 0 || method.leadlength > MAX_PLACE_NOTATION_LENGTH)
+            return false;
+
+        // The hunt bell being followed is the lowest-numbered one
+        int hunt = -1;
+        for (Bell bell = 0; bell < method.stage && hunt < 0; bell++)
+            if (method.IsHuntBell(bell))
+                hunt = bell;
+
+        int path[MAX_PLACE_NOTATION_LENGTH];
+        Row row = Row::Rounds(method.stage);
+        for (int i = 0; i < method.leadlength; i++)
+        {
+            if (hunt >= 0)
+                path[i] = GetPlace(row, hunt);
+            row.ApplyPn(method.pn[i]);
+        }
+        if (!row.IsValid())
+            return false;
+
+        classification.little = false;
+        if (hunt < 0)
+            classification.methodclass = Principle;
+        else
+            classification.methodclass = ClassifyHuntPath(method, path, classification.little);
+
+        // Count the cycles of the working bells in the lead head
+        BellBitmask seen = 0;
+        int cycles = 0;
+        for (Bell bell = 0; bell < method.stage; bell++)
+        {
+            if ((seen & (1 << bell)) != 0 || row.row[bell] == bell)
+                continue;
+            cycles++;
+            for (Bell b = bell; (seen & (1 << b)) == 0; b = row.row[b])
+                seen |= 1 << b;
+        }
+        classification.differential = cycles > 1;
+        return true;
+    }
+}
@@ -0,0 +1,48 @@
+#include "../stdint.h"
+#include "row.hpp"
+#include "method.hpp"
+
+#ifndef RINGING_CLASSIFY_HPP
+#define RINGING_CLASSIFY_HPP
+
+namespace ringing
+{
+    enum MethodClass : uint8_t
+    {
+        Principle = 0,   // no hunt bells
+        Plain = 1,       // hunt bell rings twice in each position
+        TrebleBob = 2,   // treble dodging, no internal places at cross sections
+        Surprise = 3,    // treble dodging, internal places at every cross section
+        Delight = 4,     // treble dodging, internal places at some cross sections
+        TreblePlace = 5, // hunt bell rings the same number of times (>2) in each position
+        Alliance = 6,    // hunt bell rings a different, even number of times in different positions
+        Hybrid = 7,      // any other hunt bell path
+    };
+
+    struct Classification
+    {
+        MethodClass methodclass;
+        bool little;       // hunt bell does not ring in every position
+        bool differential; // working bells form more than one cycle
+
+        inline bool IsTrebleDodging() const
+        {
+            return methodclass == TrebleBob || methodclass == Surprise || methodclass == Delight;
+        }
+        // Class in the low bits, then little and differential flags
+        inline uint8_t Pack() const { return methodclass | little << 4 | differential << 5; }
+        static inline Classification Unpack(uint8_t packed)
+        {
+            return Classification{(MethodClass)(packed & 0xF), (packed & 1 << 4) != 0, (packed & 1 << 5) != 0};
+        }
+    };
+
+    // Key of the class index of a file for a method which Classify fails on.
+    const uint8_t UNCLASSIFIED = 0xFF;
+
+    // Classify a method from its place notation, using the path of its
+    // lowest-numbered hunt bell and the cycles of its lead head.
+    bool Classify(const Method &method, Classification &classification);
+}
+
+#endif
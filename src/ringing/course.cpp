@@ -0,0 +1,40 @@
+#include "row.hpp"
+#include "method.hpp"
+#include "packedrow.hpp"
+#include "course.hpp"
+
+namespace ringing
+{
+    bool CourseCache::Build(const CompiledMethod &method)
+    {
+        Clear();
+        if (!method.IsValid())
+            return false;
+        this->method = &method;
+
+        Row row = Row::Rounds(method.stage);
+        rows[0] = PackedRow(row);
+        int count = 1;
+        int pn_i = 0;
+        do
+        {
+            if (count >= MAX_CACHED_COURSE_ROWS)
+                return false;
+            method.kernels->applycompiled(row, method.GetChange(pn_i++));
+            if (!row.IsValid())
+                return false;
+            rows[count++] = PackedRow(row);
+            pn_i %= method.leadlength;
+        } while (pn_i != 0 || !method.kernels->isrounds(row));
+
+        rowcount = count;
+        return true;
+    }
+
+    Row CourseCache::GetRow(const int index) const
+    {
+        if (index < 0 || index >= rowcount)
+            return Row::Invalid();
+        return rows[index].ToRow(method->stage);
+    }
+}
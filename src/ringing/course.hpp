@@ -0,0 +1,43 @@
+#include "../stdint.h"
+#include "row.hpp"
+#include "method.hpp"
+#include "packedrow.hpp"
+
+#ifndef RINGING_COURSE_HPP
+#define RINGING_COURSE_HPP
+
+namespace ringing
+{
+    // Maximum number of rows (including the rounds at each end) held by a CourseCache.
+    const int MAX_CACHED_COURSE_ROWS = 2048;
+
+    // Every row of a plain course, generated once so that it can be redrawn
+    // without reapplying place notation.
+    class CourseCache
+    {
+    private:
+        const CompiledMethod *method;
+        int rowcount;
+        PackedRow rows[MAX_CACHED_COURSE_ROWS];
+
+    public:
+        CourseCache() : method(nullptr), rowcount(0) {}
+
+        // Returns false if the course is invalid or too long to cache.
+        bool Build(const CompiledMethod &method);
+        inline void Clear() { rowcount = 0; }
+        inline bool IsValid() const { return rowcount > 0; }
+        inline int RowCount() const { return rowcount; }
+        inline int Stage() const { return IsValid() ? method->stage : 0; }
+
+        Row GetRow(int index) const;
+        // Directions each bell of the row came from; unset for the first row.
+        inline const ChangeDirection *GetBackDirections(int index) const
+        {
+            // row index follows the change at (index - 1) in the lead, as the course starts at rounds
+            return method->GetChange(index > 0 ? (index - 1) % method->leadlength : 0).backdirections;
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,170 @@
+#include "row.hpp"
+#include "method.hpp"
+#include "packedrow.hpp"
+#include "falseness.hpp"
+
+namespace ringing
+{
+    void FalseCourseHeads::ClearTable()
+    {
+        for (int i = 0; i < FALSENESS_HASH_CAPACITY; i++)
+            table[i].bits = 0;
+    }
+
+    bool FalseCourseHeads::AddToTable(const PackedRow &row, bool &added)
+    {
+        const uint32_t mask = FALSENESS_HASH_CAPACITY - 1;
+        uint32_t slot = row.Hash(FALSENESS_HASH_BITS);
+        for (int probes = 0; probes < FALSENESS_HASH_CAPACITY; probes++)
+        {
+            if (table[slot].bits == 0)
+            {
+                table[slot] = row;
+                added = true;
+                return true;
+            }
+            if (table[slot] == row)
+            {
+                added = false;
+                return true;
+            }
+            slot = (slot + 1) & mask;
+        }
+        return false;
+    }
+
+    bool FalseCourseHeads::Compute(const CompiledMethod &method, const int fixedtenors)
+    {
+        count = 0;
+        stage = 0;
+        if (!method.IsValid() || method.leadcount <= 0)
+            return false;
+        if (method.leadhead.row[0] != 0)
+            return false; // treble must hunt
+        if (fixedtenors < 1 || fixedtenors >= method.stage)
+            return false;
+        const int tenor = method.stage - 1;
+        // Bits of the tenors other than the tenor itself, which must also be home
+        uint64_t tenorsmask = 0;
+        for (int bell = method.stage - fixedtenors; bell < tenor; bell++)
+            tenorsmask |= (uint64_t)0xF << (4 * bell);
+
+        // Rows of the plain lead, grouped by the place of the treble
+        PackedRow rows[MAX_PLACE_NOTATION_LENGTH];
+        uint8_t byplace[MAX_BELLS][MAX_PLACE_NOTATION_LENGTH];
+        int placecounts[MAX_BELLS] = {0};
+        Row row = Row::Rounds(method.stage);
+        for (int pn_i = 0; pn_i < method.leadlength; pn_i++)
+        {
+            rows[pn_i] = PackedRow(row);
+            int place = 0;
+            while (row.row[place] != 0)
+                place++;
+            byplace[place][placecounts[place]++] = pn_i;
+            row.ApplyCompiled(method.GetChange(pn_i));
+        }
+
+        // Powers of the lead head, and which powers bring each place's bell to the tenor's place.
+        // In a differential the tenor's cycle is shorter than the course, so several powers can.
+        const int leadcount = method.leadcount < MAX_PLACE_NOTATION_LENGTH ? method.leadcount : MAX_PLACE_NOTATION_LENGTH;
+        PackedRow powers[MAX_PLACE_NOTATION_LENGTH];
+        int firstpower[MAX_BELLS];                // first power for each place, or -1
+        int nextpower[MAX_PLACE_NOTATION_LENGTH]; // next power for the same place, or -1
+        for (int place = 0; place < MAX_BELLS; place++)
+            firstpower[place] = -1;
+        const PackedRow leadhead = PackedRow(method.leadhead);
+        for (int k = 0; k < leadcount; k++)
+            powers[k] = k == 0 ? PackedRow() : powers[k - 1] * leadhead;
+        for (int k = leadcount - 1; k >= 0; k--)
+        {
+            nextpower[k] = firstpower[powers[k][tenor]];
+            firstpower[powers[k][tenor]] = k;
+        }
+
+        // False lead-head transpositions L_s * L_r^-1 between distinct rows with the treble in the same place
+        int transpositioncount = 0;
+        ClearTable();
+        for (int place = 0; place < method.stage; place++)
+            for (int r = 0; r < placecounts[place]; r++)
+            {
+                const PackedRow inverse = rows[byplace[place][r]].Inverse();
+                for (int s = 0; s < placecounts[place]; s++)
+                {
+                    if (r == s)
+                        continue;
+                    const PackedRow transposition = rows[byplace[place][s]] * inverse;
+                    bool added;
+                    if (!AddToTable(transposition, added))
+                        return false;
+                    if (added)
+                        transpositions[transpositioncount++] = transposition;
+                }
+            }
+
+        // Course heads LH^j * T * LH^m with the tenor home
+        ClearTable();
+        for (int t = 0; t < transpositioncount; t++)
+            for (int j = 0; j < leadcount; j++)
+            {
+                const PackedRow lead = powers[j] * transpositions[t];
+                for (int power = firstpower[lead.PlaceOf(tenor)]; power >= 0; power = nextpower[power])
+                {
+                    const PackedRow head = lead * powers[power];
+                    if ((head.bits & tenorsmask) != (PackedRow::ROUNDS & tenorsmask))
+                        continue;
+                    bool added;
+                    if (!AddToTable(head, added))
+                        return false;
+                    if (!added)
+                        continue;
+                    if (count >= MAX_FALSE_COURSE_HEADS)
+                        return false;
+                    heads[count++] = head;
+                }
+            }
+
+        // Insertion sort keeps the list canonical for Signature
+        for (int i = 1; i < count; i++)
+        {
+            const PackedRow head = heads[i];
+            int j = i;
+            for (; j > 0 && heads[j - 1].bits > head.bits; j--)
+                heads[j] = heads[j - 1];
+            heads[j] = head;
+        }
+        stage = method.stage;
+        return true;
+    }
+
+    bool FalseCourseHeads::Contains(const PackedRow &head) const
+    {
+        int low = 0, high = count;
+        while (low < high)
+        {
+            const int mid = (low + high) / 2;
+            if (heads[mid].bits < head.bits)
+                low = mid + 1;
+            else
+                high = mid;
+        }
+        return low < count && heads[low] == head;
+    }
+
+    uint32_t FalseCourseHeads::Signature() const
+    {
+        uint64_t hash = stage;
+        for (int i = 0; i < count; i++)
+            hash = (hash ^ heads[i].bits) * 0x100000001B3ull;
+        return (uint32_t)(hash ^ hash >> 32);
+    }
+
+    bool FalseCourseHeads::SameAs(const FalseCourseHeads &other) const
+    {
+        if (stage != other.stage || count != other.count)
+            return false;
+        for (int i = 0; i < count; i++)
+            if (heads[i] != other.heads[i])
+                return false;
+        return true;
+    }
+}
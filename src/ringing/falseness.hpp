@@ -0,0 +1,47 @@
+#include "../stdint.h"
+#include "row.hpp"
+#include "method.hpp"
+#include "packedrow.hpp"
+
+#ifndef RINGING_FALSENESS_HPP
+#define RINGING_FALSENESS_HPP
+
+namespace ringing
+{
+    const int MAX_FALSE_COURSE_HEADS = 1024;
+    const int FALSENESS_HASH_BITS = 12;
+    const int FALSENESS_HASH_CAPACITY = 1 << FALSENESS_HASH_BITS;
+
+    // The course heads, with the treble and tenor home, of the courses of a
+    // treble-dominated method which share a row with its plain course.
+    class FalseCourseHeads
+    {
+    private:
+        int stage;
+        int count;
+        PackedRow heads[MAX_FALSE_COURSE_HEADS];          // sorted
+        PackedRow transpositions[FALSENESS_HASH_CAPACITY]; // false lead-head transpositions
+        PackedRow table[FALSENESS_HASH_CAPACITY];          // hash set, zero when empty
+
+        void ClearTable();
+        // Returns false if the table is full.
+        bool AddToTable(const PackedRow &row, bool &added);
+
+    public:
+        FalseCourseHeads() : stage(0), count(0) {}
+
+        // Course heads must have the top fixedtenors bells home.
+        // Returns false if the treble is not a hunt bell or there are too many false course heads.
+        bool Compute(const CompiledMethod &method, int fixedtenors = 1);
+
+        inline int Count() const { return count; }
+        inline const PackedRow &Get(int index) const { return heads[index]; }
+        bool Contains(const PackedRow &head) const;
+        // Equal for methods with the same false course heads; methods with different ones
+        // can share a signature, so compare the course heads of matches with SameAs.
+        uint32_t Signature() const;
+        bool SameAs(const FalseCourseHeads &other) const;
+    };
+}
+
+#endif
@@ -10,6 +10,10 @@
 #else
 #include <iostream>
 #include <fstream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #endif
 
 inline uint8_t ReadU8(const uint8_t *&ptr)
@@ -39,6 +43,7 @@ inline int ReadFile(ringing::compat::FileHandle HANDLE, uint8_t *buf, int size,
 #else
 inline int ReadFile(ringing::compat::FileHandle HANDLE, uint8_t *buf, int size, int readpos)
 {
+    HANDLE->clear(); // a previous short read leaves failbit set, which would block seekg
     if (readpos != -1)
         HANDLE->seekg(readpos);
     return HANDLE->read((char *)buf, size).gcount();
@@ -48,8 +53,1244 @@ inline int ReadFile(ringing::compat::FileHandle HANDLE, uint8_t *buf, int size,
 namespace ringing
 {
     const char FILE_MAGIC_WORD[4] = {'C', 'C', 'M', 'L'};
-    const int FILE_VERSION = 0x02;
+    const int MIN_FILE_VERSION = 0x02;
+    const int FILE_VERSION = 0x03;
+    const int FILE_KNOWN_FLAGS = FrontCodedTitles | PooledPn | SymmetricPn;
     const int POINTERS_START = 0x08;
+    const int HEADER_LENGTH = 0x08;
+    const int MAX_SUMMARY_DATA_LENGTH = 1024;
+
+    const int SECTION_LENGTH = 0x0C;
+    const char INDEX_TAG[4] = {'I', 'N', 'D', 'X'};
+    const int INDEX_HEADER_LENGTH = 0x08;
+    const int MAX_INDEX_KEY_WIDTH = 32;
+    const char TITLE_BLOCKS_TAG[4] = {'T', 'B', 'L', 'K'};
+    const char PN_POOL_TAG[4] = {'P', 'N', 'P', 'L'};
+    const char TRIGRAM_TAG[4] = {'T', 'R', 'G', 'M'};
+    const int TRIGRAM_HEADER_LENGTH = 0x04;
+    const int TRIGRAM_ENTRY_LENGTH = 0x0C;
+    const int MAX_INFIX_TRIGRAMS = 16; // trigrams of a longer search are only checked against the titles
+    const int POSTING_BUFFER_LENGTH = 64;
+    // Ordinals whose posting lists an infix search intersects at a time, before reading their titles.
+    const int INFIX_WINDOW_LENGTH = 2048;
+    static_assert(INFIX_WINDOW_LENGTH % 8 == 0, "INFIX_WINDOW_LENGTH must be a whole number of bytes");
+    // An infix search stops intersecting posting lists once this few candidates are left.
+    const int INFIX_FEW_CANDIDATES = 8;
+    // OS reads an infix search takes to check a candidate far from the last, through its index entry
+    // and the front-coded block of its title.
+    const int INFIX_CANDIDATE_READS = 2;
+    // Titles an infix search reads on through to the next candidate rather than seeking, about a
+    // front-coded block's worth.
+    const int MAX_INFIX_READ_ON = 16;
+    // Stages in fewer blocks than this are read through in fewer OS reads than looking up the
+    // trigrams of a search takes, so infix searches don't use their trigram index.
+    const int MIN_TRIGRAM_SEARCH_BLOCKS = 64;
+    const char PN_HASH_INDEX_TAG[4] = {'X', 'P', 'N', 'H'};
+    const char LEAD_LENGTH_INDEX_TAG[4] = {'X', 'L', 'E', 'N'};
+    const char HUNT_BELLS_INDEX_TAG[4] = {'X', 'H', 'N', 'T'};
+    const char CLASS_INDEX_TAG[4] = {'X', 'C', 'L', 'S'};
+    const char FALSENESS_INDEX_TAG[4] = {'X', 'F', 'L', 'S'};
+    const char *const ATTRIBUTE_INDEX_TAGS[METHOD_ATTRIBUTE_COUNT] = {
+        PN_HASH_INDEX_TAG, LEAD_LENGTH_INDEX_TAG, HUNT_BELLS_INDEX_TAG, CLASS_INDEX_TAG, FALSENESS_INDEX_TAG};
+    const int ATTRIBUTE_INDEX_HEADER_LENGTH = 0x04;
+    const int ATTRIBUTE_KEY_LENGTH = 0x08;
+    const int MAX_FUZZY_DEPTH = MAX_FUZZY_SEARCH_LENGTH + MAX_FUZZY_DISTANCE + 1; // a deeper row is always over the distance
+
+    const char LIBRARY_MAGIC_WORD[4] = {'C', 'C', 'L', 'B'};
+    const int LIBRARY_VERSION = 0x01;
+    const int LIBRARY_HEADER_LENGTH = 0x08;
+    const int LIBRARY_ENTRY_LENGTH = 0x0C;
+    const int BUCKETS_UNREAD = -2; // FileReader::bucketcount until the bucket starts are needed
+
+    static bool ParseHeader(const uint8_t *header_ptr, FileLayout &layout)
+    {
+        layout.Reset();
+        for (int i = 0x00; i < 0x04; i++)
+            if (ReadU8(header_ptr) != FILE_MAGIC_WORD[i])
+                return false;
+        layout.version = ReadU8(header_ptr); // 0x04
+        if (layout.version < MIN_FILE_VERSION || layout.version > FILE_VERSION)
+            return false;
+        layout.stage = ReadU8(header_ptr);   // 0x05
+        const int flags = ReadU8(header_ptr); // 0x06; padding in v2
+        if (layout.version >= 0x03)
+        {
+            if ((flags & ~FILE_KNOWN_FLAGS) != 0)
+                return false;
+            layout.flags = flags;
+        }
+        layout.pointerdepth = ReadU8(header_ptr); // 0x07
+        if (layout.pointerdepth > charset::MAX_SEARCH_POINTER_DEPTH)
+            return false;
+        return true;
+    }
+
+    static bool MatchTag(const uint8_t *ptr, const char tag[4])
+    {
+        for (int i = 0; i < 4; i++)
+            if (ptr[i] != tag[i])
+                return false;
+        return true;
+    }
+
+    template <typename Reader>
+    static bool ReadU32At(Reader &reader, const int offset, int &value)
+    {
+        uint8_t raw[4];
+        reader.Seek(offset);
+        const uint8_t *ptr = reader.ReadBuffered(sizeof(raw), raw);
+        if (ptr == nullptr)
+            return false;
+        value = ReadU32(ptr);
+        return true;
+    }
+
+    // Read the section directory which follows the pointers in a v3 file.
+    template <typename Reader>
+    static bool ReadSections(Reader &reader, FileLayout &layout)
+    {
+        const int pointercount = charset::GetSearchPointerCount(layout.pointerdepth);
+        uint8_t raw[SECTION_LENGTH];
+        reader.Seek(POINTERS_START + 4 * pointercount);
+        const uint8_t *ptr = reader.ReadBuffered(2, raw);
+        if (ptr == nullptr)
+            return false;
+        const int sectioncount = ReadU16(ptr);
+
+        int indexstart = -1, indexlength = 0;
+        int trigramsstart = -1, trigramslength = 0;
+        int attributestart[METHOD_ATTRIBUTE_COUNT], attributelength[METHOD_ATTRIBUTE_COUNT];
+        for (int a = 0; a < METHOD_ATTRIBUTE_COUNT; a++)
+            attributestart[a] = -1;
+        for (int i = 0; i < sectioncount; i++)
+        {
+            ptr = reader.ReadBuffered(SECTION_LENGTH, raw);
+            if (ptr == nullptr)
+                return false;
+            const bool isindex = MatchTag(ptr, INDEX_TAG);
+            const bool istitleblocks = MatchTag(ptr, TITLE_BLOCKS_TAG);
+            const bool ispnpool = MatchTag(ptr, PN_POOL_TAG);
+            const bool istrigrams = MatchTag(ptr, TRIGRAM_TAG);
+            int attribute = -1;
+            for (int a = 0; a < METHOD_ATTRIBUTE_COUNT; a++)
+                if (MatchTag(ptr, ATTRIBUTE_INDEX_TAGS[a]))
+                    attribute = a;
+            ptr += 4;
+            const int start = ReadU32(ptr);
+            const int length = ReadU32(ptr);
+            if (isindex)
+            {
+                indexstart = start;
+                indexlength = length;
+            }
+            else if (istitleblocks)
+            {
+                layout.titleblocks.start = start;
+                layout.titleblocks.count = length / 4;
+            }
+            else if (ispnpool)
+            {
+                layout.pnpool.start = start;
+                layout.pnpool.count = length / 2;
+            }
+            else if (istrigrams)
+            {
+                trigramsstart = start;
+                trigramslength = length;
+            }
+            else if (attribute >= 0)
+            {
+                attributestart[attribute] = start;
+                attributelength[attribute] = length;
+            }
+            // unknown sections are skipped
+        }
+
+        if (indexstart >= 0)
+        {
+            reader.Seek(indexstart);
+            ptr = reader.ReadBuffered(INDEX_HEADER_LENGTH, raw);
+            if (ptr == nullptr)
+                return false;
+            const int count = ReadU32(ptr);
+            const int keywidth = ReadU8(ptr);
+            if (keywidth <= 0 || keywidth > MAX_INDEX_KEY_WIDTH)
+                return false;
+            if (indexlength != INDEX_HEADER_LENGTH + 4 * pointercount + (4 + keywidth) * count)
+                return false;
+            layout.index.keywidth = keywidth;
+            layout.index.bucketsstart = indexstart + INDEX_HEADER_LENGTH;
+            layout.index.entriesstart = layout.index.bucketsstart + 4 * pointercount;
+            layout.index.count = count;
+        }
+        // postings are ordinals in the index, so trigrams without one are ignored
+        if (trigramsstart >= 0 && layout.index.Exists())
+        {
+            int count;
+            if (trigramslength < TRIGRAM_HEADER_LENGTH || !ReadU32At(reader, trigramsstart, count))
+                return false;
+            if (count < 0 || count > (trigramslength - TRIGRAM_HEADER_LENGTH) / TRIGRAM_ENTRY_LENGTH)
+                return false;
+            layout.trigrams.entriesstart = trigramsstart + TRIGRAM_HEADER_LENGTH;
+            layout.trigrams.postingsstart = layout.trigrams.entriesstart + TRIGRAM_ENTRY_LENGTH * count;
+            layout.trigrams.count = count;
+        }
+        for (int a = 0; a < METHOD_ATTRIBUTE_COUNT; a++)
+        {
+            if (attributestart[a] < 0)
+                continue;
+            int count;
+            if (attributelength[a] < ATTRIBUTE_INDEX_HEADER_LENGTH || !ReadU32At(reader, attributestart[a], count))
+                return false;
+            const int tablelength = attributelength[a] - ATTRIBUTE_INDEX_HEADER_LENGTH - ATTRIBUTE_KEY_LENGTH * count;
+            if (count < 0 || count > (attributelength[a] - ATTRIBUTE_INDEX_HEADER_LENGTH) / ATTRIBUTE_KEY_LENGTH ||
+                tablelength % 4 != 0)
+                return false;
+            AttributeIndex &index = layout.attributes[a];
+            index.keysstart = attributestart[a] + ATTRIBUTE_INDEX_HEADER_LENGTH;
+            index.offsetsstart = index.keysstart + ATTRIBUTE_KEY_LENGTH * count;
+            index.total = tablelength / 4;
+            index.count = count;
+        }
+        // front-coded titles can't be read from an arbitrary method without the block index
+        if (layout.HasFlag(FrontCodedTitles) && !layout.titleblocks.Exists())
+            return false;
+        if (layout.HasFlag(PooledPn) && !layout.pnpool.Exists())
+            return false;
+        return true;
+    }
+
+    // Offset of the table of bucket starts: the index's ordinals if there is one, else the jump pointers.
+    static int GetBucketTableStart(const FileLayout &layout)
+    {
+        return layout.index.Exists() ? layout.index.bucketsstart : POINTERS_START;
+    }
+
+    // Read the directory of a library file, if the reader is at the start of one.
+    // Returns false if the file is not a library, or the directory is invalid.
+    template <typename Reader>
+    static bool ReadLibrary(Reader &reader, LibraryDirectory &library)
+    {
+        library.Reset();
+        uint8_t raw[LIBRARY_ENTRY_LENGTH];
+        reader.Seek(0);
+        const uint8_t *ptr = reader.ReadBuffered(LIBRARY_HEADER_LENGTH, raw);
+        if (ptr == nullptr || !MatchTag(ptr, LIBRARY_MAGIC_WORD))
+            return false;
+        ptr += 4;
+        if (ReadU8(ptr) != LIBRARY_VERSION)
+            return false;
+        const int stagecount = ReadU8(ptr);
+        for (int i = 0; i < stagecount; i++)
+        {
+            ptr = reader.ReadBuffered(LIBRARY_ENTRY_LENGTH, raw);
+            if (ptr == nullptr)
+                return false;
+            const int stage = ReadU8(ptr);
+            ptr += 3;
+            const int start = ReadU32(ptr);
+            const int length = ReadU32(ptr);
+            if (stage <= 0 || stage > MAX_BELLS)
+                return false;
+            if (start < 0 || length < HEADER_LENGTH || start > reader.Size() - length)
+                return false;
+            library.start[stage] = start;
+            library.length[stage] = length;
+        }
+        library.exists = true;
+        return true;
+    }
+
+    template <typename Reader>
+    static bool ReadSummary(Reader &reader, const FileLayout &layout, TitleDecoder &decoder,
+                            int *pos, charset::MBChar *title, bool decodeblock = true);
+
+    // Decode titles from the start of the block containing pos, leaving the
+    // title of the method before pos in decoder.
+    template <typename Reader>
+    static bool DecodeTitlesBefore(Reader &reader, const FileLayout &layout, TitleDecoder &decoder, const int pos)
+    {
+        // find the last block starting at or before pos
+        int lo = 0, hi = layout.titleblocks.count;
+        while (lo < hi)
+        {
+            const int mid = lo + (hi - lo) / 2;
+            int blockstart;
+            if (!ReadU32At(reader, layout.titleblocks.start + 4 * mid, blockstart))
+                return false;
+            if (blockstart <= pos)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        if (lo == 0)
+            return false;
+        int blockstart;
+        if (!ReadU32At(reader, layout.titleblocks.start + 4 * (lo - 1), blockstart))
+            return false;
+
+        reader.Seek(blockstart);
+        decoder.next = -1;
+        while (reader.Tell() < pos)
+            if (!ReadSummary(reader, layout, decoder, nullptr, nullptr, false))
+                return false;
+        return reader.Tell() == pos;
+    }
+
+    // Read the title of the method at the reader's position and move on to
+    // the next method. Front-coded titles are always decoded, since the next
+    // title may be built on this one.
+    template <typename Reader>
+    static bool ReadSummary(Reader &reader, const FileLayout &layout, TitleDecoder &decoder,
+                            int *const pos, charset::MBChar *const title, const bool decodeblock)
+    {
+        const int start = reader.Tell();
+        if (pos != nullptr)
+            *pos = start;
+
+        const bool frontcoded = layout.HasFlag(FrontCodedTitles);
+        const int header_length = frontcoded ? 4 : 3;
+        uint8_t data_header[4];
+        const uint8_t *data_header_ptr = reader.ReadBuffered(header_length, data_header);
+        if (data_header_ptr == nullptr)
+            return false;
+
+        const uint16_t data_length = ReadU16(data_header_ptr);
+        if (data_length <= 0)
+            return false;
+        if (data_length >= MAX_SUMMARY_DATA_LENGTH)
+        {
+#ifdef __sh__
+            PrintXY(1, 7, "  HUGE READ!", TEXT_MODE_NORMAL, TEXT_COLOR_RED);
+            DebugFreeze();
+#endif
+            return false;
+        }
+
+        if (title != nullptr || frontcoded)
+        {
+            const int methodname_length = ReadU8(data_header_ptr);
+            const int shared = frontcoded ? ReadU8(data_header_ptr) : 0;
+            const int suffix_length = methodname_length - shared;
+            if (suffix_length < 0)
+                return false;
+            if (data_length <= (header_length - 2) + (suffix_length + 1))
+                return false;
+            if (methodname_length + 1 > ringing::MAX_METHOD_TITLE_LENGTH)
+                return false;
+            if (shared > 0 && decoder.next != start)
+            {
+                if (!decodeblock || !DecodeTitlesBefore(reader, layout, decoder, start))
+                    return false;
+                reader.Seek(start + header_length);
+            }
+
+            uint8_t scratch[MAX_METHOD_TITLE_LENGTH];
+            const uint8_t *suffix = reader.ReadBuffered(suffix_length + 1, scratch);
+            if (suffix == nullptr || suffix[suffix_length] != 0)
+                return false;
+            charset::MBChar *const dest = frontcoded ? decoder.title : title;
+            for (int i = 0; i < suffix_length + 1; i++)
+                dest[shared + i] = suffix[i];
+            if (frontcoded)
+            {
+                decoder.next = start + sizeof(data_length) + data_length;
+                if (title != nullptr)
+                    for (int i = 0; i < methodname_length + 1; i++)
+                        title[i] = decoder.title[i];
+            }
+        }
+
+        reader.Seek(start + sizeof(data_length) + data_length);
+        return true;
+    }
+
+    // Decode the title before the method at the reader's position, if that method's title is built on it.
+    template <typename Reader>
+    static bool PrepareRecord(Reader &reader, const FileLayout &layout, TitleDecoder &decoder)
+    {
+        const int start = reader.Tell();
+        if (!layout.HasFlag(FrontCodedTitles) || decoder.next == start)
+            return true;
+        uint8_t data_header[4];
+        const uint8_t *data_header_ptr = reader.ReadBuffered(sizeof(data_header), data_header);
+        if (data_header_ptr == nullptr)
+            return false;
+        const int shared = data_header_ptr[3];
+        if (shared > 0 && !DecodeTitlesBefore(reader, layout, decoder, start))
+            return false;
+        reader.Seek(start);
+        return true;
+    }
+
+    // Read the record position and NUL-terminated key of the method with the given ordinal.
+    template <typename Reader>
+    static bool ReadIndexEntry(Reader &reader, const FileIndex &index, const int ordinal,
+                               int &pos, charset::MBChar *const key)
+    {
+        uint8_t raw[4 + MAX_INDEX_KEY_WIDTH];
+        reader.Seek(index.entriesstart + (4 + index.keywidth) * ordinal);
+        const uint8_t *ptr = reader.ReadBuffered(4 + index.keywidth, raw);
+        if (ptr == nullptr)
+            return false;
+        pos = ReadU32(ptr);
+        if (key != nullptr)
+        {
+            for (int i = 0; i < index.keywidth; i++)
+                key[i] = ptr[i];
+            key[index.keywidth] = 0;
+        }
+        return true;
+    }
+
+    // Normalise searchstring into query, which holds MAX_METHOD_TITLE_LENGTH + 1 characters.
+    // That is longer than any title, so cutting a search short there doesn't change how it compares.
+    static int NormaliseSearch(const charset::NonMBChar *const searchstring, charset::NonMBChar *const query)
+    {
+        return charset::NormaliseSearch(searchstring, query, MAX_METHOD_TITLE_LENGTH);
+    }
+
+    // Compare the normalised query against a method through the bytes of its index
+    // key, which is normalised too, only reading the title when the query is longer
+    // than the stored key.
+    template <typename Reader>
+    static charset::CompareResult CompareIndexEntry(Reader &reader, const FileIndex &index,
+                                                    const charset::NonMBChar *const query, const int length,
+                                                    const int ordinal)
+    {
+        uint8_t raw[4 + MAX_INDEX_KEY_WIDTH];
+        reader.Seek(index.entriesstart + (4 + index.keywidth) * ordinal);
+        const uint8_t *ptr = reader.ReadBuffered(4 + index.keywidth, raw);
+        if (ptr == nullptr)
+            return charset::CompareResult::Err;
+        const int pos = ReadU32(ptr);
+        charset::CompareResult result = charset::CompareSearchKey(query, length < index.keywidth ? length : index.keywidth,
+                                                                  (const charset::NonMBChar *)ptr);
+        if (result == charset::CompareResult::Contained && length > index.keywidth)
+        {
+            // the key is a truncated prefix of the search
+            charset::MBChar title[MAX_METHOD_TITLE_LENGTH];
+            reader.Seek(pos);
+            if (!reader.ReadMethodSummary(nullptr, nullptr, title))
+                return charset::CompareResult::Err;
+            result = charset::CompareNormalisedSearch(query, title);
+        }
+        return result;
+    }
+
+    // Binary search ordinals [lo, hi) of the index for the first method which
+    // is not before the normalised query or, if pastmatches, which is after it.
+    template <typename Reader>
+    static bool BisectIndex(Reader &reader, const FileIndex &index, const charset::NonMBChar *const query,
+                            const int length, int lo, int hi, const bool pastmatches, int &ordinal)
+    {
+        while (lo < hi)
+        {
+            const int mid = lo + (hi - lo) / 2;
+            const charset::CompareResult result = CompareIndexEntry(reader, index, query, length, mid);
+            if (result == charset::CompareResult::Err)
+                return false;
+            if (result == charset::CompareResult::BeforeKey ||
+                (pastmatches && result == charset::CompareResult::Contained))
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        ordinal = lo;
+        return true;
+    }
+
+    // Binary search the index within the jump pointer bucket for the ordinal
+    // of the first method which is not before searchstring, normalised as query.
+    template <typename Reader>
+    static bool SearchIndexOrdinal(Reader &reader, const FileLayout &layout,
+                                   const charset::NonMBChar *const searchstring,
+                                   const charset::NonMBChar *const query, const int length, int &ordinal)
+    {
+        const FileIndex &index = layout.index;
+        const int pointerindex = charset::GetSearchPointerIndex(searchstring, layout.pointerdepth);
+        const int lastbucket = charset::GetSearchPointerCount(layout.pointerdepth) - 1;
+
+        int lo, hi = index.count;
+        if (!reader.GetBucketStart(pointerindex, lo))
+            return false;
+        if (pointerindex < lastbucket && !reader.GetBucketStart(pointerindex + 1, hi))
+            return false;
+        if (lo < 0 || hi > index.count || lo > hi)
+            return false;
+        return BisectIndex(reader, index, query, length, lo, hi, false, ordinal);
+    }
+
+    // As SearchIndexOrdinal, but find the position of the method; pos is endpos if there is none.
+    template <typename Reader>
+    static bool SearchIndex(Reader &reader, const FileLayout &layout,
+                            const charset::NonMBChar *const searchstring, const int endpos, int &pos)
+    {
+        charset::NonMBChar query[MAX_METHOD_TITLE_LENGTH + 1];
+        const int length = NormaliseSearch(searchstring, query);
+        int ordinal;
+        if (!SearchIndexOrdinal(reader, layout, searchstring, query, length, ordinal))
+            return false;
+        if (ordinal >= layout.index.count)
+            pos = endpos;
+        else if (!ReadIndexEntry(reader, layout.index, ordinal, pos, nullptr))
+            return false;
+        return true;
+    }
+
+    // Find the ordinals [first, first + count) of the methods matching searchstring.
+    // If narrow, they are found within the given range, which must hold all of them.
+    template <typename Reader>
+    static bool SearchIndexRange(Reader &reader, const FileLayout &layout,
+                                 const charset::NonMBChar *const searchstring, const bool narrow,
+                                 int &first, int &count)
+    {
+        const FileIndex &index = layout.index;
+        if (!index.Exists() || searchstring == nullptr)
+            return false;
+        charset::NonMBChar query[MAX_METHOD_TITLE_LENGTH + 1];
+        const int length = NormaliseSearch(searchstring, query);
+        int lower, upper, end = index.count;
+        if (narrow)
+        {
+            if (first < 0 || count < 0 || count > index.count - first)
+                return false;
+            end = first + count;
+            if (!BisectIndex(reader, index, query, length, first, end, false, lower))
+                return false;
+        }
+        else if (!SearchIndexOrdinal(reader, layout, searchstring, query, length, lower))
+            return false;
+        if (!BisectIndex(reader, index, query, length, lower, end, true, upper))
+            return false;
+        first = lower;
+        count = upper - lower;
+        return true;
+    }
+
+    // Move to the method with the given ordinal in the index; the ordinal after the last is the end of the file.
+    template <typename Reader>
+    static bool SeekIndexOrdinal(Reader &reader, const FileLayout &layout, const int ordinal)
+    {
+        if (!layout.index.Exists() || ordinal < 0 || ordinal > layout.index.count)
+            return false;
+        int pos = reader.Size();
+        if (ordinal < layout.index.count && !ReadIndexEntry(reader, layout.index, ordinal, pos, nullptr))
+            return false;
+        reader.Seek(pos);
+        return true;
+    }
+
+    // A position in the posting list of one trigram of an infix search.
+    struct PostingCursor
+    {
+        int pos;       // offset of the next gap after those buffered
+        int remaining; // gaps not yet read
+        int ordinal;   // last ordinal read: -1 before the first, or the method count once the list is exhausted
+        // Bytes read ahead from the list, so that reading titles between candidates doesn't evict its block
+        uint8_t buffer[POSTING_BUFFER_LENGTH];
+        const uint8_t *next;
+        const uint8_t *end;
+    };
+
+    // Binary search the trigram index for three normalised search characters. found is false if no
+    // title contains them, and listed is false if so many do that their postings aren't stored.
+    template <typename Reader>
+    static bool FindTrigram(Reader &reader, const TrigramIndex &trigrams, const charset::NonMBChar *const trigram,
+                            bool &found, bool &listed, PostingCursor &cursor)
+    {
+        uint8_t raw[TRIGRAM_ENTRY_LENGTH];
+        int lo = 0, hi = trigrams.count;
+        found = false;
+        while (lo < hi)
+        {
+            const int mid = lo + (hi - lo) / 2;
+            reader.Seek(trigrams.entriesstart + TRIGRAM_ENTRY_LENGTH * mid);
+            const uint8_t *ptr = reader.ReadBuffered(TRIGRAM_ENTRY_LENGTH, raw);
+            if (ptr == nullptr)
+                return false;
+            int diff = 0;
+            for (int i = 0; i < 3 && diff == 0; i++)
+                diff = (uint8_t)trigram[i] - ptr[i];
+            if (diff < 0)
+                hi = mid;
+            else if (diff > 0)
+                lo = mid + 1;
+            else
+            {
+                ptr += 3;
+                listed = ReadU8(ptr) != 0;
+                cursor.pos = trigrams.postingsstart + ReadU32(ptr);
+                cursor.remaining = ReadU32(ptr);
+                cursor.ordinal = -1;
+                cursor.next = cursor.end = cursor.buffer;
+                found = true;
+                return true;
+            }
+        }
+        return true;
+    }
+
+    // Read the next ordinal of a posting list, stored as a little-endian base-128 varint of its gap from the last.
+    template <typename Reader>
+    static bool NextPosting(Reader &reader, const FileIndex &index, PostingCursor &cursor)
+    {
+        if (cursor.remaining <= 0)
+        {
+            cursor.ordinal = index.count;
+            return true;
+        }
+        int gap = 0;
+        for (int shift = 0;; shift += 7)
+        {
+            if (cursor.next == cursor.end)
+            {
+                int length = reader.Size() - cursor.pos;
+                if (length > POSTING_BUFFER_LENGTH)
+                    length = POSTING_BUFFER_LENGTH;
+                reader.Seek(cursor.pos);
+                const uint8_t *ptr = length > 0 ? reader.ReadBuffered(length, cursor.buffer) : nullptr;
+                if (ptr == nullptr)
+                    return false;
+                for (int i = 0; i < length; i++) // the cache may be refilled before the list is next read
+                    cursor.buffer[i] = ptr[i];
+                cursor.pos += length;
+                cursor.next = cursor.buffer;
+                cursor.end = cursor.buffer + length;
+            }
+            const uint8_t byte = *cursor.next++;
+            if (shift > 28)
+                return false;
+            gap |= (byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0)
+                break;
+        }
+        cursor.remaining--;
+        cursor.ordinal += 1 + gap;
+        if (cursor.ordinal > index.count || cursor.ordinal < 0)
+            cursor.ordinal = index.count;
+        return true;
+    }
+
+    // Where an infix search has read titles up to, so it can read on to a nearby candidate instead of
+    // seeking to it, which decodes a front-coded title from the start of its block.
+    struct InfixTitles
+    {
+        int ordinal; // ordinal of the method after the last title read, or -1 before the first
+        int pos;     // position of that method
+    };
+
+    // Read the title of the method with the given ordinal.
+    template <typename Reader>
+    static bool ReadInfixTitle(Reader &reader, const FileLayout &layout, InfixTitles &titles,
+                               const int ordinal, charset::MBChar *const title)
+    {
+        if (titles.ordinal < 0 || ordinal < titles.ordinal || ordinal - titles.ordinal > MAX_INFIX_READ_ON)
+        {
+            if (!SeekIndexOrdinal(reader, layout, ordinal))
+                return false;
+        }
+        else
+        {
+            reader.Seek(titles.pos);
+            for (; titles.ordinal < ordinal; titles.ordinal++)
+                if (!reader.ReadMethodSummary(nullptr, nullptr, nullptr))
+                    return false;
+        }
+        if (!reader.ReadMethodSummary(nullptr, nullptr, title))
+            return false;
+        titles.ordinal = ordinal + 1;
+        titles.pos = reader.Tell();
+        return true;
+    }
+
+    // Whether the title of the method with the given ordinal contains the normalised query,
+    // only reading the title when the query isn't in the method's truncated index key.
+    template <typename Reader>
+    static bool MatchInfix(Reader &reader, const FileLayout &layout, InfixTitles &titles,
+                           const charset::NonMBChar *const query, const int ordinal, bool &match)
+    {
+        charset::MBChar key[MAX_INDEX_KEY_WIDTH + 1];
+        int pos;
+        if (!ReadIndexEntry(reader, layout.index, ordinal, pos, key))
+            return false;
+        match = charset::ContainsSearch(query, key);
+        if (!match && key[layout.index.keywidth - 1] != 0)
+        {
+            charset::MBChar title[MAX_METHOD_TITLE_LENGTH];
+            if (!ReadInfixTitle(reader, layout, titles, ordinal, title))
+                return false;
+            match = charset::ContainsSearch(query, title);
+        }
+        return true;
+    }
+
+    // Whether reading through the titles of ordinals is cheaper than checking candidates of them one by one.
+    template <typename Reader>
+    static bool ScanIsCheaper(Reader &reader, const FileIndex &index, const int candidates, const int ordinals)
+    {
+        // sequential reads fetch two blocks at once
+        const uint64_t scanreads = (uint64_t)reader.Size() * ordinals / index.count / (2 * FILE_BLOCK_SIZE);
+        return (uint64_t)candidates * INFIX_CANDIDATE_READS > scanreads;
+    }
+
+    // Find the ordinals of up to maxcount methods, from fromordinal on, whose titles contain
+    // searchstring. Every such method has each of its trigrams, so the candidates are those in
+    // the posting lists of them all, whose titles are then checked. Without a trigram index, or
+    // when there are so many candidates that checking them would read more, every title is read
+    // in turn instead.
+    template <typename Reader>
+    static bool SearchInfixOrdinals(Reader &reader, const FileLayout &layout,
+                                    const charset::NonMBChar *const searchstring, const int fromordinal,
+                                    int *const ordinals, const int maxcount, int &count)
+    {
+        const FileIndex &index = layout.index;
+        count = 0;
+        if (!index.Exists() || searchstring == nullptr || fromordinal < 0)
+            return false;
+
+        // normalise the search as the trigrams were
+        charset::NonMBChar query[MAX_METHOD_TITLE_LENGTH];
+        int length = 0;
+        for (const charset::NonMBChar *c = searchstring; length < MAX_METHOD_TITLE_LENGTH - 1; length++)
+            if ((query[length] = charset::ReadSearchChar(c)) == '\0')
+                break;
+        query[length] = 0;
+
+        // look up each trigram, keeping the listed ones from rarest to commonest
+        PostingCursor cursors[MAX_INFIX_TRIGRAMS];
+        int cursorcount = 0;
+        const bool usetrigrams = layout.trigrams.Exists() && reader.Size() > MIN_TRIGRAM_SEARCH_BLOCKS * FILE_BLOCK_SIZE;
+        for (int i = 0; usetrigrams && i + 3 <= length && cursorcount < MAX_INFIX_TRIGRAMS; i++)
+        {
+            bool found, listed;
+            if (!FindTrigram(reader, layout.trigrams, query + i, found, listed, cursors[cursorcount]))
+                return false;
+            if (!found) // no title contains it
+                return true;
+            if (!listed)
+                continue;
+            for (int j = cursorcount; j > 0 && cursors[j - 1].remaining > cursors[j].remaining; j--)
+            {
+                const PostingCursor cursor = cursors[j];
+                cursors[j] = cursors[j - 1];
+                cursors[j - 1] = cursor;
+            }
+            cursorcount++;
+        }
+        for (int i = 0; i < cursorcount; i++) // the buffer pointers didn't move with the cursors
+            cursors[i].next = cursors[i].end = cursors[i].buffer;
+
+        InfixTitles titles = {-1, 0};
+        const bool scan = cursorcount == 0 || ScanIsCheaper(reader, index, cursors[0].remaining, index.count);
+        for (int windowstart = fromordinal; count < maxcount && windowstart < index.count;
+             windowstart += INFIX_WINDOW_LENGTH)
+        {
+            const int windowend = index.count - windowstart < INFIX_WINDOW_LENGTH ? index.count
+                                                                                   : windowstart + INFIX_WINDOW_LENGTH;
+            // Intersect the lists over the window, rarest first, reading through each in turn so that
+            // its blocks are read once. Another list is only read while it can strike out more candidates
+            // than reading it costs.
+            uint8_t candidates[INFIX_WINDOW_LENGTH / 8], present[INFIX_WINDOW_LENGTH / 8];
+            int candidatecount = 0;
+            for (int i = 0; !scan && i < cursorcount && (i == 0 || candidatecount > INFIX_FEW_CANDIDATES); i++)
+            {
+                uint8_t *const bits = i == 0 ? candidates : present;
+                PostingCursor &cursor = cursors[i];
+                for (int byte = 0; byte < INFIX_WINDOW_LENGTH / 8; byte++)
+                    bits[byte] = 0;
+                while (cursor.ordinal < windowstart)
+                    if (!NextPosting(reader, index, cursor))
+                        return false;
+                while (cursor.ordinal < windowend)
+                {
+                    const int offset = cursor.ordinal - windowstart;
+                    bits[offset >> 3] |= 1 << (offset & 7);
+                    if (!NextPosting(reader, index, cursor))
+                        return false;
+                }
+                candidatecount = 0;
+                for (int byte = 0; byte < INFIX_WINDOW_LENGTH / 8; byte++)
+                {
+                    if (i > 0)
+                        candidates[byte] &= present[byte];
+                    for (uint8_t bit = candidates[byte]; bit != 0; bit &= bit - 1)
+                        candidatecount++;
+                }
+            }
+
+            // check the candidates in order, so that nearby ones share blocks
+            const bool scanwindow = scan || ScanIsCheaper(reader, index, candidatecount, windowend - windowstart);
+            charset::MBChar title[MAX_METHOD_TITLE_LENGTH];
+            for (int ordinal = windowstart; count < maxcount && ordinal < windowend; ordinal++)
+            {
+                bool match;
+                if (scanwindow)
+                {
+                    if (!ReadInfixTitle(reader, layout, titles, ordinal, title))
+                        return false;
+                    match = charset::ContainsSearch(query, title);
+                }
+                else
+                {
+                    const int offset = ordinal - windowstart;
+                    if ((candidates[offset >> 3] & 1 << (offset & 7)) == 0)
+                        continue;
+                    if (!MatchInfix(reader, layout, titles, query, ordinal, match))
+                        return false;
+                }
+                if (match)
+                    ordinals[count++] = ordinal;
+            }
+        }
+        return true;
+    }
+
+    // Add a fuzzy match to the closest found so far, which are ordered by distance then ordinal.
+    // Returns false if it is no closer than any of them and there is no room for it.
+    static bool AddFuzzyMatch(int *const ordinals, int *const distances, const int maxcount, int &count,
+                              const int ordinal, const int distance)
+    {
+        if (count == maxcount && distance >= distances[count - 1])
+            return false;
+        int i = count < maxcount ? count++ : count - 1;
+        for (; i > 0 && distances[i - 1] > distance; i--)
+        {
+            ordinals[i] = ordinals[i - 1];
+            distances[i] = distances[i - 1];
+        }
+        ordinals[i] = ordinal;
+        distances[i] = distance;
+        return true;
+    }
+
+    // Find the methods whose normalised titles start within maxdistance edits of searchstring.
+    // The index is walked in order as a trie, keeping a row of the edit distance table for each
+    // character of the current key, so consecutive keys only compute the rows after their common
+    // prefix. Once no row entry is within maxdistance (or, with maxcount matches, closer than the
+    // furthest of them), every key with that prefix has the same distance, so the walk skips past
+    // all of them: this prunes whole buckets after a typo early on.
+    template <typename Reader>
+    static bool SearchFuzzyOrdinals(Reader &reader, const FileLayout &layout,
+                                    const charset::NonMBChar *const searchstring, const int maxdistance,
+                                    int *const ordinals, int *const distances, const int maxcount, int &count)
+    {
+        const FileIndex &index = layout.index;
+        count = 0;
+        if (!index.Exists() || searchstring == nullptr || maxcount <= 0 ||
+            maxdistance < 0 || maxdistance > MAX_FUZZY_DISTANCE)
+            return false;
+
+        charset::NonMBChar query[MAX_FUZZY_SEARCH_LENGTH + 1];
+        int length = 0;
+        for (const charset::NonMBChar *c = searchstring; (query[length] = charset::ReadSearchChar(c)) != '\0';)
+            if (++length > MAX_FUZZY_SEARCH_LENGTH)
+                return false;
+
+        // rows[i][j]: edits between the first i characters of the key and the first j of the query
+        uint8_t rows[MAX_FUZZY_DEPTH + 1][MAX_FUZZY_SEARCH_LENGTH + 1];
+        uint8_t best[MAX_FUZZY_DEPTH + 1]; // least distance of the query from the first i characters, or fewer
+        charset::NonMBChar text[MAX_FUZZY_DEPTH + 1]; // normalised start of the current key
+        int validrows = 0;                            // rows computed for the start of text
+        for (int j = 0; j <= length; j++)
+            rows[0][j] = j;
+        best[0] = length;
+
+        charset::MBChar key[MAX_INDEX_KEY_WIDTH + 1];
+        charset::MBChar title[MAX_METHOD_TITLE_LENGTH];
+        int ordinal = 0;
+        while (ordinal < index.count)
+        {
+            // once there are maxcount matches, only closer ones are wanted
+            const int bound = count == maxcount ? distances[count - 1] - 1 : maxdistance;
+            if (bound < 0)
+                break;
+            int pos;
+            if (!ReadIndexEntry(reader, index, ordinal, pos, key))
+                return false;
+            bool readtitle = false;
+            const charset::MBChar *c = key;
+            int depth = 0;
+            // keep the rows of the prefix shared with the previous key
+            while (depth < validrows && *c != '\0')
+            {
+                const charset::MBChar *next = c;
+                if (charset::ReadSearchChar(next) != text[depth])
+                    break;
+                c = next;
+                depth++;
+            }
+
+            bool dead = false;
+            while (depth < MAX_FUZZY_DEPTH)
+            {
+                if (*c == '\0')
+                {
+                    // the key may be cut short of the title
+                    if (readtitle || key[index.keywidth - 1] == 0)
+                        break;
+                    reader.Seek(pos);
+                    if (!reader.ReadMethodSummary(nullptr, nullptr, title))
+                        return false;
+                    readtitle = true;
+                    c = title;
+                    for (int i = 0; i < depth && *c != '\0'; i++)
+                        charset::ReadSearchChar(c);
+                    continue;
+                }
+                const charset::NonMBChar t = charset::ReadSearchChar(c);
+                text[depth] = t;
+                const uint8_t *const above = rows[depth];
+                uint8_t *const row = rows[depth + 1];
+                row[0] = depth + 1;
+                uint8_t least = row[0];
+                for (int j = 1; j <= length; j++)
+                {
+                    int d = above[j - 1] + (query[j - 1] == t ? 0 : 1);
+                    if (above[j] + 1 < d)
+                        d = above[j] + 1;
+                    if (row[j - 1] + 1 < d)
+                        d = row[j - 1] + 1;
+                    row[j] = d;
+                    if (d < least)
+                        least = d;
+                }
+                best[depth + 1] = row[length] < best[depth] ? row[length] : best[depth];
+                depth++;
+                if (least > bound)
+                {
+                    dead = true;
+                    break;
+                }
+            }
+            validrows = depth;
+            const int distance = best[depth];
+
+            if (!dead) // the whole key was read
+            {
+                if (distance <= maxdistance)
+                    AddFuzzyMatch(ordinals, distances, maxcount, count, ordinal, distance);
+                ordinal++;
+                continue;
+            }
+
+            // every key with this prefix has the same distance
+            charset::NonMBChar prefix[MAX_FUZZY_DEPTH + 1];
+            for (int i = 0; i < depth; i++)
+                prefix[i] = text[i];
+            prefix[depth] = 0;
+            // gallop forward first, as most prefixes are shared by only a few keys close by
+            int lo = ordinal + 1, hi = index.count, end;
+            for (int step = 1; ordinal + step < index.count; step *= 2)
+            {
+                const charset::CompareResult result = CompareIndexEntry(reader, index, prefix, depth, ordinal + step);
+                if (result == charset::CompareResult::Err)
+                    return false;
+                if (result != charset::CompareResult::Contained)
+                {
+                    hi = ordinal + step;
+                    break;
+                }
+                lo = ordinal + step + 1;
+            }
+            if (!BisectIndex(reader, index, prefix, depth, lo, hi, true, end))
+                return false;
+            if (distance <= maxdistance)
+                for (int o = ordinal; o < end; o++)
+                    if (!AddFuzzyMatch(ordinals, distances, maxcount, count, o, distance))
+                        break;
+            ordinal = end;
+        }
+        return true;
+    }
+
+    // Jump to the method's bucket pointer and scan forward through the
+    // titles for the first method which is not before searchstring.
+    template <typename Reader>
+    static bool SearchLinear(Reader &reader, const FileLayout &layout,
+                             const charset::NonMBChar *const searchstring, int &pos)
+    {
+        const int pointerindex = charset::GetSearchPointerIndex(searchstring, layout.pointerdepth);
+        int pointer_dest;
+        if (!reader.GetBucketStart(pointerindex, pointer_dest))
+            return false;
+        reader.Seek(pointer_dest);
+
+        charset::NonMBChar query[MAX_METHOD_TITLE_LENGTH + 1];
+        NormaliseSearch(searchstring, query);
+        charset::MBChar title[MAX_METHOD_TITLE_LENGTH];
+        do
+        {
+            if (reader.EndOfFile())
+            {
+                pointer_dest = reader.Size();
+                break;
+            }
+            if (!reader.ReadMethodSummary(&pointer_dest, nullptr, title))
+            {
+#ifdef __sh__
+                PrintXY(1, 6, "  Failed read.", TEXT_MODE_NORMAL, TEXT_COLOR_RED);
+                DebugFreeze();
+#endif
+                return false;
+            }
+        } while (charset::CompareNormalisedSearch(query, title) == charset::CompareResult::BeforeKey);
+
+        pos = pointer_dest;
+        return true;
+    }
+
+    uint32_t HashPlaceNotation(const Method &method)
+    {
+        uint32_t hash = 0x811C9DC5;
+        for (int i = 0; i < method.leadlength; i++)
+        {
+            hash = (hash ^ (method.pn[i] & 0xFF)) * 0x01000193;
+            hash = (hash ^ (method.pn[i] >> 8)) * 0x01000193;
+        }
+        return hash;
+    }
+
+    // Point iterator at the group of ptr* of the methods whose attribute is value, found by a binary
+    // search of the index's values; the group ends where the next value's starts.
+    template <typename Reader>
+    static bool QueryAttributeIndex(Reader &reader, const AttributeIndex &index, const uint32_t value,
+                                    AttributeIterator &iterator)
+    {
+        iterator.next = iterator.end = 0;
+        iterator.pos = -1;
+        if (!index.Exists())
+            return false;
+        uint8_t raw[2 * ATTRIBUTE_KEY_LENGTH];
+        int low = 0, high = index.count; // find the first value at or after value
+        while (low < high)
+        {
+            const int mid = (low + high) / 2;
+            reader.Seek(index.keysstart + ATTRIBUTE_KEY_LENGTH * mid);
+            const uint8_t *ptr = reader.ReadBuffered(4, raw);
+            if (ptr == nullptr)
+                return false;
+            if (ReadU32(ptr) < value)
+                low = mid + 1;
+            else
+                high = mid;
+        }
+        if (low == index.count)
+            return true;
+        const bool last = low == index.count - 1;
+        reader.Seek(index.keysstart + ATTRIBUTE_KEY_LENGTH * low);
+        const uint8_t *ptr = reader.ReadBuffered(last ? ATTRIBUTE_KEY_LENGTH : 2 * ATTRIBUTE_KEY_LENGTH, raw);
+        if (ptr == nullptr)
+            return false;
+        if (ReadU32(ptr) != value)
+            return true;
+        const int first = ReadU32(ptr);
+        int end = index.total;
+        if (!last)
+        {
+            ReadU32(ptr); // next value
+            end = ReadU32(ptr);
+        }
+        if (first < 0 || first > end || end > index.total)
+            return false;
+        iterator.next = index.offsetsstart + 4 * first;
+        iterator.end = index.offsetsstart + 4 * end;
+        return true;
+    }
+
+    template <typename Reader>
+    static bool NextAttributeMatch(Reader &reader, AttributeIterator &iterator, int &pos)
+    {
+        if (iterator.Done() || !ReadU32At(reader, iterator.next, pos))
+            return false;
+        iterator.next += 4;
+        iterator.pos = pos;
+        return true;
+    }
+
+    // Move iterator on to its first method at or after target. The positions are in
+    // order, so gallop ahead then bisect rather than reading every one of them.
+    template <typename Reader>
+    static bool SkipAttributeMatches(Reader &reader, AttributeIterator &iterator, const int target)
+    {
+        const int remaining = iterator.Remaining();
+        int low = 0, high = 1; // the methods before low are before target
+        int pos;
+        for (; high <= remaining; high *= 2)
+        {
+            if (!ReadU32At(reader, iterator.next + 4 * (high - 1), pos))
+                return false;
+            if (pos >= target)
+                break;
+            low = high;
+        }
+        if (high > remaining)
+            high = remaining;
+        while (low < high)
+        {
+            const int mid = (low + high) / 2;
+            if (!ReadU32At(reader, iterator.next + 4 * mid, pos))
+                return false;
+            if (pos < target)
+                low = mid + 1;
+            else
+                high = mid;
+        }
+        iterator.next += 4 * low;
+        return true;
+    }
+
+    // Find the next method which all of the iterators have, by moving each one up to the
+    // furthest position any of them is at until they all agree.
+    template <typename Reader>
+    static bool NextCommonAttributeMatch(Reader &reader, AttributeIterator *const iterators, const int count, int &pos)
+    {
+        if (count <= 0)
+            return false;
+        int target = 0; // after the last match returned by any of them
+        for (int i = 0; i < count; i++)
+            if (iterators[i].pos >= target)
+                target = iterators[i].pos + 1;
+        for (int i = 0; i < count;)
+        {
+            AttributeIterator &iterator = iterators[i];
+            if (iterator.pos < target &&
+                (!SkipAttributeMatches(reader, iterator, target) || !NextAttributeMatch(reader, iterator, iterator.pos)))
+                return false;
+            if (iterator.pos > target)
+            {
+                target = iterator.pos;
+                i = 0;
+            }
+            else
+                i++;
+        }
+        pos = target;
+        return true;
+    }
+
+    // Parse the data of a method record, excluding its length prefix. A
+    // front-coded title is left as its suffix, after shared bytes of the
+    // previous title, for FinishTitle; pooled place notation is left as its
+    // index in the pool, poolref, for ReadPool.
+    static bool ParseMethod(const uint8_t *ptr, const int data_length, const FileLayout &layout,
+                            MethodView &view, int &shared, int &poolref)
+    {
+        const uint8_t *endptr = ptr + data_length;
+        view.stage = layout.stage;
+        shared = 0;
+        if (ptr + 1 > endptr)
+            return false;
+        view.titlelength = ReadU8(ptr);
+        if (layout.HasFlag(FrontCodedTitles))
+        {
+            if (ptr + 1 > endptr)
+                return false;
+            shared = ReadU8(ptr);
+            if (shared > view.titlelength || view.titlelength + 1 > MAX_METHOD_TITLE_LENGTH)
+                return false;
+            view.titlelength -= shared;
+        }
+        if (ptr + view.titlelength + 1 > endptr)
+            return false;
+        view.title = (const charset::MBChar *)ptr;
+        ptr += view.titlelength + 1;
+        if (ptr + 2 > endptr)
+            return false;
+        view.leadlength = ReadU16(ptr);
+        view.symmetry = 0;
+        view.storedlength = view.leadlength;
+        if (layout.HasFlag(SymmetricPn))
+        {
+            if (ptr + 1 > endptr)
+                return false;
+            view.symmetry = ReadU8(ptr);
+            if (view.symmetry > 0)
+            {
+                // (2 * first - 1) + (2 * second - 1) changes
+                if (view.leadlength % 2 != 0)
+                    return false;
+                view.storedlength = (view.leadlength + 2) / 2;
+                if (view.symmetry >= view.storedlength)
+                    return false;
+            }
+        }
+        view.poolpn = nullptr;
+        view.poolcount = 0;
+        poolref = 0;
+        if (layout.HasFlag(PooledPn))
+        {
+            if (ptr + 6 > endptr)
+                return false;
+            poolref = ReadU32(ptr);
+            view.poolcount = ReadU16(ptr);
+            if (view.poolcount > view.storedlength)
+                return false;
+            if (poolref < 0 || poolref > layout.pnpool.count - view.poolcount)
+                return false;
+        }
+        const int inlinecount = view.storedlength - view.poolcount;
+        if (ptr + 2 * inlinecount > endptr)
+            return false;
+        view.pn = ptr;
+        ptr += 2 * inlinecount;
+        if (ptr + 2 > endptr)
+            return false;
+        view.leadcount = ReadU16(ptr);
+        if (ptr + 2 > endptr)
+            return false;
+        view.huntbells = ReadU16(ptr);
+        // if (ptr != endptr) there was excess length - ignored
+        return true;
+    }
+
+    // Rebuild a front-coded title parsed by ParseMethod in decoder; next is the position after the method.
+    static void FinishTitle(const FileLayout &layout, TitleDecoder &decoder, MethodView &view,
+                            const int shared, const int next)
+    {
+        if (!layout.HasFlag(FrontCodedTitles))
+            return;
+        for (int i = 0; i < view.titlelength + 1; i++)
+            decoder.title[shared + i] = view.title[i];
+        view.title = decoder.title;
+        view.titlelength += shared;
+        decoder.next = next;
+    }
+
+    // Point view at the pooled place notation parsed by ParseMethod, which is
+    // copied into scratch if the reader can't return it in place. Leaves the
+    // reader at next.
+    template <typename Reader>
+    static bool ReadPool(Reader &reader, const FileLayout &layout, MethodView &view,
+                         const int poolref, uint8_t *scratch, const int next)
+    {
+        if (view.poolcount > 0)
+        {
+            reader.Seek(layout.pnpool.start + 2 * poolref);
+            view.poolpn = reader.ReadBuffered(2 * view.poolcount, scratch);
+            if (view.poolpn == nullptr)
+                return false;
+        }
+        reader.Seek(next);
+        return true;
+    }
+
+    bool MethodView::ToMethod(Method &method) const
+    {
+        if (titlelength + 1 > MAX_METHOD_TITLE_LENGTH)
+            return false;
+        if (leadlength > MAX_PLACE_NOTATION_LENGTH)
+            return false;
+        method.stage = stage;
+        for (int i = 0; i < titlelength + 1; i++)
+            method.title[i] = title[i];
+        method.leadlength = leadlength;
+        for (int i = 0; i < leadlength; i++)
+            method.pn[i] = GetPn(i);
+        method.leadcount = leadcount;
+        method.huntbells = huntbells;
+        return true;
+    }
 
     bool FileReader::TryOpen(const compat::FileChar *const filename)
     {
@@ -65,6 +1306,16 @@ namespace ringing
 #endif
         Close(); // ensure no previous file is still open
         filehandle = handle;
+        ClearCache();
+        pos = 0;
+        base = 0;
+        filesize = OSSize();
+        size = filesize;
+        if (ReadLibrary(*this, library))
+        {
+            size = 0; // until a stage is selected
+            return true;
+        }
         if (!ReadHeader())
         {
             Close();
@@ -73,6 +1324,35 @@ namespace ringing
         return true;
     }
 
+    bool FileReader::SelectStage(const int stage)
+    {
+        if (!library.HasStage(stage))
+            return false;
+        base = library.start[stage];
+        size = library.length[stage];
+        if (stagelayouts[stage].version != 0)
+        {
+            layout = stagelayouts[stage];
+            decoder.next = -1;
+            bucketcount = BUCKETS_UNREAD;
+            return true;
+        }
+        if (!ReadHeader() || layout.stage != stage)
+        {
+            layout.Reset();
+            size = 0;
+            return false;
+        }
+        stagelayouts[stage] = layout;
+        return true;
+    }
+
+    void FileReader::ResetStageLayouts()
+    {
+        for (int stage = 0; stage <= MAX_BELLS; stage++)
+            stagelayouts[stage].Reset();
+    }
+
     bool FileReader::IsOpen()
     {
 #ifdef __sh__
@@ -84,21 +1364,54 @@ namespace ringing
 
     bool FileReader::ReadHeader()
     {
-        uint8_t header[8];
-        if (ReadFile(filehandle, header, sizeof(header), 0) != sizeof(header))
+        uint8_t header[HEADER_LENGTH];
+        Seek(0);
+        decoder.next = -1;
+        bucketcount = -1;
+        if (Read(header, sizeof(header)) != sizeof(header))
             return false;
-        const uint8_t *header_ptr = header;
-        for (int i = 0x00; i < 0x04; i++)
-            if (ReadU8(header_ptr) != FILE_MAGIC_WORD[i])
-                return false;
-        if (ReadU8(header_ptr) != FILE_VERSION) // 0x04
+        if (!ParseHeader(header, layout))
             return false;
-        stage = ReadU8(header_ptr);        // 0x05
-        ReadU8(header_ptr);                // padding byte 0x06
-        pointerdepth = ReadU8(header_ptr); // 0x07
+        if (layout.version >= 0x03 && !ReadSections(*this, layout))
+            return false;
+        return LoadBuckets();
+    }
+
+    bool FileReader::LoadBuckets()
+    {
+        bucketcount = -1;
+        const int count = charset::GetSearchPointerCount(layout.pointerdepth);
+        if (count > FILE_MAX_BUCKETS)
+            return true; // too many to hold, so read as needed
+        uint8_t raw[4];
+        Seek(GetBucketTableStart(layout));
+        for (int i = 0; i < count; i++)
+        {
+            const uint8_t *ptr = ReadBuffered(sizeof(raw), raw);
+            if (ptr == nullptr)
+                return false;
+            bucketstarts[i] = ReadU32(ptr);
+        }
+        bucketcount = count;
         return true;
     }
 
+    bool FileReader::GetBucketStart(const int bucket, int &start)
+    {
+        if (bucketcount == BUCKETS_UNREAD && !LoadBuckets())
+            return false;
+        if (bucketcount >= 0)
+        {
+            if (bucket < 0 || bucket >= bucketcount)
+                return false;
+            start = bucketstarts[bucket];
+            return true;
+        }
+        if (bucket < 0 || bucket >= charset::GetSearchPointerCount(layout.pointerdepth))
+            return false;
+        return ReadU32At(*this, GetBucketTableStart(layout) + 4 * bucket, start);
+    }
+
     void FileReader::Close()
     {
         if (IsOpen())
@@ -111,154 +1424,501 @@ namespace ringing
 #endif
         }
         filehandle = compat::emptyFileHandle;
+        bucketcount = -1;
+        ClearCache();
+        pos = 0;
+        size = 0;
+        base = 0;
+        filesize = 0;
+        layout.Reset();
+        library.Reset();
+        ResetStageLayouts();
+        decoder.next = -1;
+    }
+
+    void FileReader::ClearCache()
+    {
+        for (int i = 0; i < FILE_CACHE_BLOCKS; i++)
+        {
+            blockstart[i] = -1;
+            blocklength[i] = 0;
+            blockused[i] = 0;
+        }
+        usecounter = 0;
+        nextsequential = -1;
+    }
+
+    // Find the cached block starting at start, fetching it on a miss; -1 if it is past the end of the file.
+    int FileReader::FindBlock(const int start)
+    {
+        for (int i = 0; i < FILE_CACHE_BLOCKS; i++)
+        {
+            if (blockstart[i] == start)
+            {
+                blockused[i] = ++usecounter;
+                return i;
+            }
+        }
+        if (start < 0 || start >= filesize)
+            return -1;
+
+        // Reading on from the last fetch is likely to continue, so read ahead into a pair of
+        // adjacent slots (contiguous in cache) with one call; otherwise fetch a single block.
+        const bool sequential = start == nextsequential;
+        int slot = 0;
+        if (sequential)
+        {
+            unsigned int oldest = ~0u;
+            for (int i = 0; i < FILE_CACHE_BLOCKS; i += 2)
+            {
+                const unsigned int used = blockused[i] > blockused[i + 1] ? blockused[i] : blockused[i + 1];
+                if (used < oldest)
+                {
+                    oldest = used;
+                    slot = i;
+                }
+            }
+        }
+        else
+        {
+            for (int i = 1; i < FILE_CACHE_BLOCKS; i++)
+                if (blockused[i] < blockused[slot])
+                    slot = i;
+        }
+        const int count = sequential ? 2 : 1;
+
+        int length = count * FILE_BLOCK_SIZE;
+        if (start + length > filesize)
+            length = filesize - start;
+        const int fetched = ReadFile(filehandle, cache[slot], length, start);
+        stats.osreads++;
+        if (fetched > 0)
+            stats.bytesfetched += fetched;
+
+        for (int i = 0; i < count; i++)
+        {
+            const int valid = fetched - i * FILE_BLOCK_SIZE;
+            if (valid <= 0)
+            {
+                blockstart[slot + i] = -1;
+                blocklength[slot + i] = 0;
+                blockused[slot + i] = 0;
+                continue;
+            }
+            blockstart[slot + i] = start + i * FILE_BLOCK_SIZE;
+            blocklength[slot + i] = valid < FILE_BLOCK_SIZE ? valid : FILE_BLOCK_SIZE;
+            blockused[slot + i] = ++usecounter;
+        }
+        if (fetched <= 0)
+            return -1;
+        nextsequential = start + count * FILE_BLOCK_SIZE;
+        blockused[slot] = ++usecounter; // the block asked for is the most recently used
+        return slot;
+    }
+
+    int FileReader::Read(uint8_t *const buf, int length)
+    {
+        if (pos < 0)
+            return 0;
+        if (length > size - pos) // don't read on into the next stage of a library
+            length = size - pos;
+        int done = 0;
+        while (done < length)
+        {
+            const int offset = (base + pos) % FILE_BLOCK_SIZE;
+            const int block = FindBlock(base + pos - offset);
+            if (block < 0)
+                break;
+            int n = blocklength[block] - offset;
+            if (n <= 0)
+                break;
+            if (n > length - done)
+                n = length - done;
+            const uint8_t *src = cache[block] + offset;
+            for (int i = 0; i < n; i++)
+                buf[done + i] = src[i];
+            done += n;
+            pos += n;
+        }
+        return done;
+    }
+
+    const uint8_t *FileReader::ReadBuffered(const int length, uint8_t *const scratch)
+    {
+        if (pos < 0 || length < 0 || length > size - pos)
+            return nullptr;
+        const int offset = (base + pos) % FILE_BLOCK_SIZE;
+        if (offset + length <= FILE_BLOCK_SIZE)
+        {
+            const int block = FindBlock(base + pos - offset);
+            if (block < 0 || offset + length > blocklength[block])
+                return nullptr;
+            pos += length;
+            return cache[block] + offset;
+        }
+        if (Read(scratch, length) != length)
+            return nullptr;
+        return scratch;
     }
 
     bool FileReader::ReadMethod(ringing::Method &method)
     {
+        if (!PrepareRecord(*this, layout, decoder))
+            return false;
+        const int start = Tell();
         uint8_t data_header[2];
-        if (ReadFile(filehandle, data_header, sizeof(data_header), -1) != sizeof(data_header))
+        const uint8_t *data_header_ptr = ReadBuffered(sizeof(data_header), data_header);
+        if (data_header_ptr == nullptr)
             return false;
-        const uint8_t *data_header_ptr = data_header;
         uint16_t data_length = ReadU16(data_header_ptr);
 #ifdef __sh__
-        uint8_t data[data_length];
+        uint8_t scratch[data_length];
 #else
         // bad practice - only for CASIO compat
-        uint8_t *data = (uint8_t *)alloca(data_length);
+        uint8_t *scratch = (uint8_t *)alloca(data_length);
 #endif
-        if (ReadFile(filehandle, data, data_length, -1) != data_length)
+        const uint8_t *data;
+        if (layout.HasFlag(PooledPn))
+        {
+            // reading the pool could evict the record from the cache, so keep a copy
+            if (Read(scratch, data_length) != data_length)
+                return false;
+            data = scratch;
+        }
+        else if ((data = ReadBuffered(data_length, scratch)) == nullptr)
             return false;
 
-        method.stage = stage;
-
-        const uint8_t *ptr = data;
-        const uint8_t *endptr = data + data_length;
-        if (ptr + 1 > endptr)
+        MethodView view;
+        int shared, poolref;
+        if (!ParseMethod(data, data_length, layout, view, shared, poolref))
             return false;
-        uint8_t methodname_length = ReadU8(ptr);
-        if (ptr + methodname_length + 1 > endptr)
+        const int next = start + sizeof(data_length) + data_length;
+        FinishTitle(layout, decoder, view, shared, next);
+        if (view.poolcount > 0)
+        {
+#ifdef __sh__
+            uint8_t poolscratch[2 * view.poolcount];
+#else
+            uint8_t *poolscratch = (uint8_t *)alloca(2 * view.poolcount);
+#endif
+            if (!ReadPool(*this, layout, view, poolref, poolscratch, next))
+                return false;
+            return view.ToMethod(method); // before poolscratch goes out of scope
+        }
+        return view.ToMethod(method);
+    }
+
+    bool FileReader::ReadMethodSummary(int *const pos, int *const stage, charset::MBChar *const title)
+    {
+        if (stage != nullptr)
+            *stage = layout.stage;
+        return ReadSummary(*this, layout, decoder, pos, title);
+    }
+
+    bool FileReader::SearchOrdinals(const charset::NonMBChar *const searchstring, int &first, int &count)
+    {
+        return SearchIndexRange(*this, layout, searchstring, false, first, count);
+    }
+
+    bool FileReader::NarrowOrdinals(const charset::NonMBChar *const searchstring, int &first, int &count)
+    {
+        return SearchIndexRange(*this, layout, searchstring, true, first, count);
+    }
+
+    bool FileReader::SeekOrdinal(const int ordinal)
+    {
+        return SeekIndexOrdinal(*this, layout, ordinal);
+    }
+
+    bool FileReader::SearchInfix(const charset::NonMBChar *const searchstring, const int fromordinal,
+                                 int *const ordinals, const int maxcount, int &count)
+    {
+        return SearchInfixOrdinals(*this, layout, searchstring, fromordinal, ordinals, maxcount, count);
+    }
+
+    bool FileReader::SearchFuzzy(const charset::NonMBChar *const searchstring, const int maxdistance,
+                                 int *const ordinals, int *const distances, const int maxcount, int &count)
+    {
+        return SearchFuzzyOrdinals(*this, layout, searchstring, maxdistance, ordinals, distances, maxcount, count);
+    }
+
+    bool FileReader::QueryAttribute(const MethodAttribute attribute, const uint32_t value, AttributeIterator &iterator)
+    {
+        return QueryAttributeIndex(*this, layout.GetAttributeIndex(attribute), value, iterator);
+    }
+
+    bool FileReader::NextMatch(AttributeIterator &iterator, int &pos)
+    {
+        return NextAttributeMatch(*this, iterator, pos);
+    }
+
+    bool FileReader::NextCommonMatch(AttributeIterator *const iterators, const int count, int &pos)
+    {
+        return NextCommonAttributeMatch(*this, iterators, count, pos);
+    }
+
+    bool FileReader::Search(const charset::NonMBChar *const searchstring, int *const pos)
+    {
+        if (layout.pointerdepth < 0)
             return false;
-        if (methodname_length + 1 > ringing::MAX_METHOD_TITLE_LENGTH)
+        if (searchstring == nullptr)
             return false;
-        for (int i = 0; i < methodname_length + 1; i++)
-            method.title[i] = ReadU8(ptr);
-        if (ptr + 2 > endptr)
+
+        int dest;
+        if (layout.index.Exists())
+        {
+            if (!SearchIndex(*this, layout, searchstring, Size(), dest))
+                return false;
+        }
+        else if (!SearchLinear(*this, layout, searchstring, dest))
             return false;
-        method.leadlength = ReadU16(ptr);
-        if (ptr + 2 * method.leadlength > endptr)
+
+        Seek(dest);
+        if (pos != nullptr)
+            *pos = dest;
+        return true;
+    }
+
+#ifdef __sh__
+    int FileReader::OSSize() { return Bfile_GetFileSize_OS(filehandle); }
+#else
+    int FileReader::OSSize()
+    {
+        filehandle->clear();
+        filehandle->seekg(0, std::ios::end);
+        return filehandle->tellg();
+    }
+#endif
+
+#ifndef __sh__
+    bool MappedFileReader::TryOpen(const char *const filename)
+    {
+        Close(); // ensure no previous file is still open
+        const int fd = open(filename, O_RDONLY);
+        if (fd < 0)
             return false;
-        if (method.leadlength > ringing::MAX_PLACE_NOTATION_LENGTH)
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size < HEADER_LENGTH || st.st_size > 0x7FFFFFFF)
+        {
+            close(fd);
             return false;
-        for (int i = 0; i < method.leadlength; i++)
-            method.pn[i] = ReadU16(ptr);
-        if (ptr + 2 > endptr)
+        }
+        void *const mapping = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd); // the mapping keeps the file open
+        if (mapping == MAP_FAILED)
             return false;
-        method.leadcount = ReadU16(ptr);
-        if (ptr + 2 > endptr)
+
+        this->mapping = (const uint8_t *)mapping;
+        mappingsize = st.st_size;
+        data = this->mapping;
+        size = mappingsize;
+        if (ReadLibrary(*this, library))
+        {
+            size = 0; // until a stage is selected
+            return true;
+        }
+        if (!ReadHeader())
+        {
+            Close();
             return false;
-        method.huntbells = ReadU16(ptr);
-        // if (ptr != endptr) there was excess length - ignored
+        }
         return true;
     }
 
-    bool FileReader::ReadMethodSummary(int *const pos, int *const stage, charset::MBChar *const title)
+    bool MappedFileReader::ReadHeader()
     {
-        int start = Tell();
-        if (pos != nullptr)
-            *pos = start;
+        pos = HEADER_LENGTH;
+        decoder.next = -1;
+        if (size < HEADER_LENGTH || !ParseHeader(data, layout))
+            return false;
+        if (layout.version >= 0x03 && !ReadSections(*this, layout))
+            return false;
+        return true;
+    }
 
-        uint8_t data_header[3];
-        if (ReadFile(filehandle, data_header, sizeof(data_header), -1) != sizeof(data_header))
+    bool MappedFileReader::GetBucketStart(const int bucket, int &start)
+    {
+        if (bucket < 0 || bucket >= charset::GetSearchPointerCount(layout.pointerdepth))
+            return false;
+        const int offset = GetBucketTableStart(layout) + 4 * bucket;
+        if (offset + 4 > size)
             return false;
+        const uint8_t *ptr = data + offset;
+        start = ReadU32(ptr);
+        return true;
+    }
 
-        const uint8_t *data_header_ptr = data_header;
-        uint16_t data_length = ReadU16(data_header_ptr);
-        if (data_length <= 0)
+    bool MappedFileReader::SelectStage(const int stage)
+    {
+        if (!library.HasStage(stage))
             return false;
-        if (data_length >= 1024)
+        data = mapping + library.start[stage];
+        size = library.length[stage];
+        if (!ReadHeader() || layout.stage != stage)
         {
-#ifdef __sh__
-            PrintXY(1, 7, "  HUGE READ!", TEXT_MODE_NORMAL, TEXT_COLOR_RED);
-            DebugFreeze();
-#endif
+            layout.Reset();
+            size = 0;
             return false;
         }
+        return true;
+    }
+
+    const uint8_t *MappedFileReader::ReadBuffered(const int length, uint8_t *)
+    {
+        if (pos < 0 || length < 0 || pos + length > size)
+            return nullptr;
+        const uint8_t *const ptr = data + pos;
+        pos += length;
+        return ptr;
+    }
+
+    void MappedFileReader::Close()
+    {
+        if (IsOpen())
+            munmap((void *)mapping, mappingsize);
+        mapping = nullptr;
+        mappingsize = 0;
+        data = nullptr;
+        size = 0;
+        pos = 0;
+        layout.Reset();
+        library.Reset();
+        decoder.next = -1;
+    }
+
+    bool MappedFileReader::ReadMethodView(MethodView &view)
+    {
+        if (!PrepareRecord(*this, layout, decoder))
+            return false;
+        if (pos < 0 || pos + 2 > size)
+            return false;
+        const uint8_t *ptr = data + pos;
+        const uint16_t data_length = ReadU16(ptr);
+        if (pos + 2 + data_length > size)
+            return false;
+        int shared, poolref;
+        if (!ParseMethod(ptr, data_length, layout, view, shared, poolref))
+            return false;
+        const int next = pos + 2 + data_length;
+        FinishTitle(layout, decoder, view, shared, next);
+        // the mapping needs no scratch
+        return ReadPool(*this, layout, view, poolref, nullptr, next);
+    }
+
+    bool MappedFileReader::ReadMethod(Method &method)
+    {
+        MethodView view;
+        if (!ReadMethodView(view))
+            return false;
+        return view.ToMethod(method);
+    }
 
+    bool MappedFileReader::ReadMethodSummary(int *const pos, int *const stage, charset::MBChar *const title)
+    {
         if (stage != nullptr)
-            *stage = this->stage;
-        if (title != nullptr)
-        {
-            uint8_t methodname_length = ReadU8(data_header_ptr);
-            if (data_length <= 1 + (methodname_length + 1))
-                return false;
-            if (methodname_length + 1 > ringing::MAX_METHOD_TITLE_LENGTH)
-                return false;
-            if (ReadFile(filehandle, (uint8_t *)title, methodname_length + 1, -1) != methodname_length + 1)
-                return false;
-            if (title[methodname_length] != 0)
-                return false;
-        }
+            *stage = layout.stage;
+        return ReadSummary(*this, layout, decoder, pos, title);
+    }
 
-        Seek(start + sizeof(data_length) + data_length);
+    bool MappedFileReader::SearchOrdinals(const charset::NonMBChar *const searchstring, int &first, int &count)
+    {
+        return SearchIndexRange(*this, layout, searchstring, false, first, count);
+    }
 
-        return true;
+    bool MappedFileReader::NarrowOrdinals(const charset::NonMBChar *const searchstring, int &first, int &count)
+    {
+        return SearchIndexRange(*this, layout, searchstring, true, first, count);
     }
 
-    bool FileReader::Search(const charset::NonMBChar *const searchstring, int *const pos)
+    bool MappedFileReader::SeekOrdinal(const int ordinal)
+    {
+        return SeekIndexOrdinal(*this, layout, ordinal);
+    }
+
+    bool MappedFileReader::SearchInfix(const charset::NonMBChar *const searchstring, const int fromordinal,
+                                       int *const ordinals, const int maxcount, int &count)
+    {
+        return SearchInfixOrdinals(*this, layout, searchstring, fromordinal, ordinals, maxcount, count);
+    }
+
+    bool MappedFileReader::SearchFuzzy(const charset::NonMBChar *const searchstring, const int maxdistance,
+                                       int *const ordinals, int *const distances, const int maxcount, int &count)
+    {
+        return SearchFuzzyOrdinals(*this, layout, searchstring, maxdistance, ordinals, distances, maxcount, count);
+    }
+
+    bool MappedFileReader::QueryAttribute(const MethodAttribute attribute, const uint32_t value,
+                                          AttributeIterator &iterator)
     {
-        if (pointerdepth < 0)
+        return QueryAttributeIndex(*this, layout.GetAttributeIndex(attribute), value, iterator);
+    }
+
+    bool MappedFileReader::NextMatch(AttributeIterator &iterator, int &pos)
+    {
+        return NextAttributeMatch(*this, iterator, pos);
+    }
+
+    bool MappedFileReader::NextCommonMatch(AttributeIterator *const iterators, const int count, int &pos)
+    {
+        return NextCommonAttributeMatch(*this, iterators, count, pos);
+    }
+
+    bool MappedFileReader::Search(const charset::NonMBChar *const searchstring, int *const pos)
+    {
+        if (layout.pointerdepth < 0)
             return false;
         if (searchstring == nullptr)
             return false;
 
-        int pointerindex = charset::GetSearchPointerIndex(searchstring, pointerdepth);
+        if (layout.index.Exists() || layout.HasFlag(FrontCodedTitles))
+        {
+            int dest;
+            if (layout.index.Exists() ? !SearchIndex(*this, layout, searchstring, Size(), dest)
+                                      : !SearchLinear(*this, layout, searchstring, dest))
+                return false;
+            Seek(dest);
+            if (pos != nullptr)
+                *pos = dest;
+            return true;
+        }
 
-        uint8_t pointer_raw[4];
-        const int pointer_pos = POINTERS_START + sizeof(pointer_raw) * pointerindex;
-        if (ReadFile(filehandle, pointer_raw, sizeof(pointer_raw), pointer_pos) != sizeof(pointer_raw))
+        const int pointerindex = charset::GetSearchPointerIndex(searchstring, layout.pointerdepth);
+        int pointer_dest;
+        if (!GetBucketStart(pointerindex, pointer_dest))
             return false;
-        const uint8_t *pointer_raw_ptr = pointer_raw;
-        int pointer_dest = ReadU32(pointer_raw_ptr);
         Seek(pointer_dest);
 
-        charset::MBChar title[MAX_METHOD_TITLE_LENGTH];
-        do
+        // Compare titles in place rather than copying each one out
+        charset::NonMBChar query[MAX_METHOD_TITLE_LENGTH + 1];
+        NormaliseSearch(searchstring, query);
+        while (true)
         {
             if (EndOfFile())
             {
                 pointer_dest = Size();
                 break;
             }
-            if (!ReadMethodSummary(&pointer_dest, nullptr, title))
-            {
-#ifdef __sh__
-                PrintXY(1, 6, "  Failed read.", TEXT_MODE_NORMAL, TEXT_COLOR_RED);
-                DebugFreeze();
-#endif
+            pointer_dest = this->pos;
+            if (pointer_dest < 0 || pointer_dest + 3 > size)
                 return false;
-            }
-        } while (charset::CompareSearch(searchstring, title) == charset::CompareResult::BeforeKey);
+            const uint8_t *ptr = data + pointer_dest;
+            const uint16_t data_length = ReadU16(ptr);
+            const uint8_t methodname_length = ReadU8(ptr);
+            if (data_length <= 1 + (methodname_length + 1) || data_length >= MAX_SUMMARY_DATA_LENGTH)
+                return false;
+            if (methodname_length + 1 > ringing::MAX_METHOD_TITLE_LENGTH)
+                return false;
+            if (pointer_dest + 3 + methodname_length + 1 > size || ptr[methodname_length] != 0)
+                return false;
+            if (charset::CompareNormalisedSearch(query, (const charset::MBChar *)ptr) != charset::CompareResult::BeforeKey)
+                break;
+            Seek(pointer_dest + 2 + data_length);
+        }
 
         Seek(pointer_dest);
         if (pos != nullptr)
             *pos = pointer_dest;
         return true;
     }
-
-#ifdef __sh__
-    int FileReader::Tell() { return Bfile_TellFile_OS(filehandle); }
-    void FileReader::Seek(int pos) { Bfile_SeekFile_OS(filehandle, pos); }
-    int FileReader::Size() { return Bfile_GetFileSize_OS(filehandle); }
-#else
-    int FileReader::Tell() { return filehandle->tellg(); }
-    void FileReader::Seek(int pos) { filehandle->seekg(pos); }
-    int FileReader::Size()
-    {
-        int cpos = Tell();
-        filehandle->seekg(0, std::ios::end);
-        int size = Tell();
-        Seek(cpos);
-        return size;
-    }
 #endif
 }
@@ -24,16 +24,255 @@ namespace ringing
 #endif
     }
 
+    // A method record parsed in place, pointing into the buffer it was read from.
+    struct MethodView
+    {
+        int stage;
+        const charset::MBChar *title; // null-terminated name of method
+        int titlelength;              // excluding the null terminator
+        int leadlength;
+        int symmetry;     // length of the first of two palindromes making up the lead, or 0
+        int storedlength; // PlaceNotations stored: the first half of each palindrome, or the whole lead
+        const uint8_t *poolpn; // the first poolcount stored PlaceNotations, from the file's pool
+        int poolcount;
+        const uint8_t *pn; // the other storedlength-poolcount little-endian PlaceNotations, possibly unaligned
+        int leadcount;
+        BellBitmask huntbells;
+
+        // Index of change i of the lead among the stored PlaceNotations.
+        inline int GetStoredIndex(int i) const
+        {
+            if (symmetry == 0)
+                return i;
+            const int first = symmetry, second = storedlength - symmetry;
+            if (i < 2 * first - 1)
+                return i < first ? i : 2 * first - 2 - i;
+            i -= 2 * first - 1;
+            return first + (i < second ? i : 2 * second - 2 - i);
+        }
+        inline PlaceNotation GetStoredPn(int k) const
+        {
+            const uint8_t *p = k < poolcount ? poolpn + 2 * k : pn + 2 * (k - poolcount);
+            return (PlaceNotation)(p[0] | p[1] << 8);
+        }
+        inline PlaceNotation GetPn(int i) const { return GetStoredPn(GetStoredIndex(i)); }
+        // Copy into a Method; false if the method is too large for it.
+        bool ToMethod(Method &method) const;
+    };
+
+    // Flags in the header of a v3 file.
+    enum FileFlags : uint8_t
+    {
+        FrontCodedTitles = 0x01, // titles only store what differs from the previous title
+        PooledPn = 0x02,         // place notation may start with a run from the file's pool
+        SymmetricPn = 0x04,      // leads of two palindromes only store the first half of each
+    };
+
+    // Location of the sorted index section of a v3 file.
+    struct FileIndex
+    {
+        int count;        // number of methods in the file, or -1 if there is no index
+        int keywidth;     // bytes of normalised search key stored for each method
+        int bucketsstart; // offset of the ordinal of the first method in each jump pointer bucket
+        int entriesstart; // offset of the (ptr*, key) entry of each method, in sorted order
+
+        inline bool Exists() const { return count >= 0; }
+    };
+
+    // Location of the title block index of a file with front-coded titles.
+    struct TitleBlocks
+    {
+        int count; // number of blocks, or -1 if there is no block index
+        int start; // offset of the ptr* to the first method of each block
+
+        inline bool Exists() const { return count >= 0; }
+    };
+
+    // Location of the place notation pool of a file with pooled place notation.
+    struct PnPool
+    {
+        int count; // number of PlaceNotations in the pool, or -1 if there is no pool
+        int start; // offset of the first PlaceNotation
+
+        inline bool Exists() const { return count >= 0; }
+    };
+
+    // Location of the trigram index of a file, which finds titles containing a search anywhere.
+    struct TrigramIndex
+    {
+        int count;         // number of trigrams, or -1 if there is no trigram index
+        int entriesstart;  // offset of the sorted (trigram, postings) entry of each trigram
+        int postingsstart; // offset which the postings of each entry are relative to
+
+        inline bool Exists() const { return count >= 0; }
+    };
+
+    // Attributes of a method which a file may have a secondary index of.
+    enum class MethodAttribute : uint8_t
+    {
+        PnHash,     // HashPlaceNotation of the whole lead
+        LeadLength, // changes in a lead
+        HuntBells,  // bitmask of the bells which are in place at the lead head
+        Class,      // Classification::Pack, or UNCLASSIFIED if the place notation isn't valid
+        Falseness,  // FalseCourseHeads::Signature with the tenor home, for methods it can be computed for
+    };
+    const int METHOD_ATTRIBUTE_COUNT = 5;
+
+    // Location of a secondary index, which finds the methods with a value of an attribute.
+    struct AttributeIndex
+    {
+        int count;        // number of distinct values, or -1 if there is no such index
+        int keysstart;    // offset of the sorted (value, first offset) entry of each value
+        int offsetsstart; // offset of the ptr* of every method, grouped by value and in title order in each group
+        int total;        // number of ptr* in the table
+
+        inline bool Exists() const { return count >= 0; }
+    };
+
+    // The positions of the methods found by a secondary index, in title order.
+    struct AttributeIterator
+    {
+        int next; // offset of the ptr* of the next method
+        int end;  // offset after the ptr* of the last method
+        int pos;  // position of the method last returned, or -1 before the first
+
+        inline bool Done() const { return next >= end; }
+        inline int Remaining() const { return (end - next) / 4; }
+    };
+
+    // Key of the place notation index: the 32-bit FNV-1a hash of the little-endian lead of place
+    // notation. Methods with different place notation can share a hash, so compare that of matches.
+    uint32_t HashPlaceNotation(const Method &method);
+
+    // Everything read from the header and section directory of a file.
+    struct FileLayout
+    {
+        int version;
+        int flags;
+        int stage;
+        int pointerdepth;
+        FileIndex index;
+        TitleBlocks titleblocks;
+        PnPool pnpool;
+        TrigramIndex trigrams;
+        AttributeIndex attributes[METHOD_ATTRIBUTE_COUNT];
+
+        inline const AttributeIndex &GetAttributeIndex(MethodAttribute attribute) const
+        {
+            return attributes[(int)attribute];
+        }
+        inline bool HasFlag(FileFlags flag) const { return (flags & flag) != 0; }
+        inline void Reset()
+        {
+            version = 0;
+            flags = 0;
+            stage = 0;
+            pointerdepth = -1;
+            index.count = -1;
+            titleblocks.count = -1;
+            pnpool.count = -1;
+            trigrams.count = -1;
+            for (int i = 0; i < METHOD_ATTRIBUTE_COUNT; i++)
+                attributes[i].count = -1;
+        }
+    };
+
+    // Directory of a library file, which holds a whole method file for each stage.
+    struct LibraryDirectory
+    {
+        bool exists;               // whether the open file is a library
+        int start[MAX_BELLS + 1];  // offset of the method file of each stage, or -1 if it is missing
+        int length[MAX_BELLS + 1]; // length of the method file of each stage
+
+        inline bool HasStage(int stage) const { return exists && stage > 0 && stage <= MAX_BELLS && start[stage] >= 0; }
+        inline void Reset()
+        {
+            exists = false;
+            for (int stage = 0; stage <= MAX_BELLS; stage++)
+            {
+                start[stage] = -1;
+                length[stage] = 0;
+            }
+        }
+    };
+
+    // The last title decoded from a file with front-coded titles, which the next title is built on.
+    struct TitleDecoder
+    {
+        charset::MBChar title[MAX_METHOD_TITLE_LENGTH];
+        int next; // position of the method after the one title belongs to, or -1
+
+        TitleDecoder() : next(-1) {}
+    };
+
+    // Size of each block FileReader reads from the OS at once.
+    const int FILE_BLOCK_SIZE = 2048;
+    // Number of blocks cached; a sequential miss fills an adjacent pair of them in one read.
+    const int FILE_CACHE_BLOCKS = 4;
+    static_assert(FILE_CACHE_BLOCKS % 2 == 0, "FILE_CACHE_BLOCKS must be even");
+
+    // Most jump pointer buckets whose starts FileReader holds in memory, at 4 bytes each;
+    // the bucket starts of files with deeper pointer tables are read through the cache.
+    const int FILE_MAX_BUCKETS = 1024;
+
+    // Longest search, and most edits, for a fuzzy search.
+    const int MAX_FUZZY_SEARCH_LENGTH = 24;
+    const int MAX_FUZZY_DISTANCE = 3;
+
+    struct FileReadStats
+    {
+        int osreads;      // calls to the OS read function
+        int bytesfetched; // bytes returned by those calls
+    };
+
     class FileReader
     {
     private:
         compat::FileHandle filehandle;
-        int stage;
+        FileLayout layout;
+        TitleDecoder decoder;
+        LibraryDirectory library;
+        // Layout of each stage of the library, kept from when it was first selected
+        // so that switching back to it doesn't read its header again; version 0 until then.
+        FileLayout stagelayouts[MAX_BELLS + 1];
 
-        int pointerdepth;
+        int pos;      // logical position of the next read
+        int size;     // size of the method file being read
+        int base;     // offset of the method file being read: the selected stage's in a library, else 0
+        int filesize; // size of the whole file, read once on opening
+
+        // Least recently used cache of FILE_BLOCK_SIZE-aligned blocks of the whole file
+        uint8_t cache[FILE_CACHE_BLOCKS][FILE_BLOCK_SIZE];
+        int blockstart[FILE_CACHE_BLOCKS];  // file offset of each block, or -1 if empty
+        int blocklength[FILE_CACHE_BLOCKS]; // bytes valid in each block; short at the end of the file
+        unsigned int blockused[FILE_CACHE_BLOCKS];
+        unsigned int usecounter;
+        int nextsequential; // start of the block after the last one fetched
+        FileReadStats stats;
+
+        // Start of each jump pointer bucket, read when the header is, so that searching doesn't read them
+        int bucketstarts[FILE_MAX_BUCKETS];
+        int bucketcount; // buckets in bucketstarts, or -1 if they aren't held in memory, or -2 until they are read
+
+        void ClearCache();
+        void ResetStageLayouts();
+        bool LoadBuckets();
+        int FindBlock(int start);
+        int OSSize();
 
     public:
-        FileReader(compat::FileHandle filehandle = compat::emptyFileHandle) : filehandle(filehandle) {}
+        FileReader(compat::FileHandle filehandle = compat::emptyFileHandle)
+            : filehandle(filehandle), stats{0, 0}, bucketcount(-1)
+        {
+            layout.Reset();
+            library.Reset();
+            ResetStageLayouts();
+            ClearCache();
+            pos = 0;
+            base = 0;
+            filesize = IsOpen() ? OSSize() : 0;
+            size = filesize;
+        }
 #ifndef __sh__
         ~FileReader() { Close(); }
 #endif
@@ -42,16 +281,138 @@ namespace ringing
         bool IsOpen();
         bool ReadHeader();
 
+        // Whether the open file is a library, from which a stage must be selected before reading.
+        inline bool IsLibrary() const { return library.exists; }
+        // Read the method file of a stage from the open library; the cache is kept across stages,
+        // and switching back to a stage selected before only reads from it again when searching.
+        bool SelectStage(int stage);
+        // Stage of the method file being read, or 0 if there is none.
+        inline int GetStage() const { return layout.stage; }
+
+        // Read from the current position through the cache; returns the number of bytes read.
+        int Read(uint8_t *buf, int length);
+        // Read length bytes, returning a pointer into the cache if they lie in one block,
+        // otherwise copying them into scratch. Returns nullptr on a short read.
+        const uint8_t *ReadBuffered(int length, uint8_t *scratch);
+
+        inline const FileReadStats &GetReadStats() const { return stats; }
+        inline void ResetReadStats() { stats = {0, 0}; }
+
         bool ReadMethod(Method &method);
         bool ReadMethodSummary(int *pos, int *stage, charset::MBChar *title);
 
+        // First method of a jump pointer bucket: its ordinal in the index if the file has one, else its position.
+        bool GetBucketStart(int bucket, int &start);
         bool Search(const charset::NonMBChar *searchstring, int *pos);
 
-        int Tell();
-        void Seek(int pos);
-        int Size();
+        // Files with an index can find methods by their ordinal, in sorted order.
+        inline bool HasIndex() const { return layout.index.Exists(); }
+        // Find the ordinals [first, first + count) of the methods matching searchstring.
+        bool SearchOrdinals(const charset::NonMBChar *searchstring, int &first, int &count);
+        // As SearchOrdinals, within [first, first + count), which must hold all the matches.
+        bool NarrowOrdinals(const charset::NonMBChar *searchstring, int &first, int &count);
+        // Move to the method with the given ordinal, or to the end of the file for the ordinal after the last.
+        bool SeekOrdinal(int ordinal);
+
+        // Files with a trigram index can find methods whose titles contain searchstring anywhere.
+        inline bool HasTrigrams() const { return layout.trigrams.Exists(); }
+        // Find the ordinals of up to maxcount methods, from fromordinal on, whose titles contain
+        // searchstring; needs an index, and checks every title if there is no trigram index.
+        bool SearchInfix(const charset::NonMBChar *searchstring, int fromordinal, int *ordinals, int maxcount, int &count);
+        // Find the ordinals of up to maxcount methods whose titles start within maxdistance edits (at most
+        // MAX_FUZZY_DISTANCE) of searchstring, closest first, with their distances; needs an index.
+        bool SearchFuzzy(const charset::NonMBChar *searchstring, int maxdistance,
+                         int *ordinals, int *distances, int maxcount, int &count);
+
+        // Files with secondary indexes can find methods by their attributes instead of their titles.
+        inline bool HasAttributeIndex(MethodAttribute attribute) const
+        {
+            return layout.GetAttributeIndex(attribute).Exists();
+        }
+        // Point iterator at the methods whose attribute has the given value, which is empty if
+        // there are none; needs an index of the attribute.
+        bool QueryAttribute(MethodAttribute attribute, uint32_t value, AttributeIterator &iterator);
+        // Position of the next method of iterator; false once there are no more, or on a read error.
+        bool NextMatch(AttributeIterator &iterator, int &pos);
+        // Position of the next method in every one of count iterators, for queries of several
+        // attributes; false once there are no more, or on a read error.
+        bool NextCommonMatch(AttributeIterator *iterators, int count, int &pos);
+
+        inline int Tell() { return pos; }
+        inline void Seek(int pos) { this->pos = pos; }
+        inline int Size() { return size; }
         bool EndOfFile() { return Tell() >= Size(); }
     };
+
+#ifndef __sh__
+    // Reads a whole file mapped into memory: records are returned as views
+    // into the mapping, so scanning a file makes no copies or syscalls.
+    // Views are valid until the reader is closed, except that front-coded
+    // titles are decoded into the reader and only last until the next read.
+    class MappedFileReader
+    {
+    private:
+        const uint8_t *mapping;
+        int mappingsize;
+        const uint8_t *data; // start of the method file being read, within the mapping
+        int size;
+        int pos;
+        FileLayout layout;
+        TitleDecoder decoder;
+        LibraryDirectory library;
+
+        bool ReadHeader();
+
+    public:
+        MappedFileReader() : mapping(nullptr), mappingsize(0), data(nullptr), size(0), pos(0)
+        {
+            layout.Reset();
+            library.Reset();
+        }
+        ~MappedFileReader() { Close(); }
+        MappedFileReader(const MappedFileReader &) = delete;
+        MappedFileReader &operator=(const MappedFileReader &) = delete;
+
+        bool TryOpen(const char *filename);
+        void Close();
+        inline bool IsOpen() const { return mapping != nullptr; }
+        inline bool IsLibrary() const { return library.exists; }
+        bool SelectStage(int stage);
+
+        // Read length bytes, returning a pointer into the mapping; scratch is unused.
+        const uint8_t *ReadBuffered(int length, uint8_t *scratch);
+
+        bool ReadMethodView(MethodView &view);
+        bool ReadMethod(Method &method);
+        bool ReadMethodSummary(int *pos, int *stage, charset::MBChar *title);
+
+        bool GetBucketStart(int bucket, int &start);
+        bool Search(const charset::NonMBChar *searchstring, int *pos);
+
+        inline bool HasIndex() const { return layout.index.Exists(); }
+        bool SearchOrdinals(const charset::NonMBChar *searchstring, int &first, int &count);
+        bool NarrowOrdinals(const charset::NonMBChar *searchstring, int &first, int &count);
+        bool SeekOrdinal(int ordinal);
+
+        inline bool HasTrigrams() const { return layout.trigrams.Exists(); }
+        bool SearchInfix(const charset::NonMBChar *searchstring, int fromordinal, int *ordinals, int maxcount, int &count);
+        bool SearchFuzzy(const charset::NonMBChar *searchstring, int maxdistance,
+                         int *ordinals, int *distances, int maxcount, int &count);
+
+        inline bool HasAttributeIndex(MethodAttribute attribute) const
+        {
+            return layout.GetAttributeIndex(attribute).Exists();
+        }
+        bool QueryAttribute(MethodAttribute attribute, uint32_t value, AttributeIterator &iterator);
+        bool NextMatch(AttributeIterator &iterator, int &pos);
+        bool NextCommonMatch(AttributeIterator *iterators, int count, int &pos);
+
+        inline int Tell() const { return pos; }
+        inline void Seek(int pos) { this->pos = pos; }
+        inline int Size() const { return size; }
+        inline bool EndOfFile() const { return pos >= size; }
+    };
+#endif
 }
 
 #endif
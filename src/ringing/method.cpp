@@ -3,4 +3,63 @@
 
 namespace ringing
 {
+    static_assert(MAX_COMPILED_CHANGES <= UNCOMPILED_CHANGE, "change indexes must fit in uint8_t");
+
+    bool CompiledMethod::Compile(const Method &method)
+    {
+        stage = 0;
+        leadlength = 0;
+        changecount = 0;
+        leadcount = 0;
+        leadhead.Invalidate();
+        kernels = &GetRowKernels(0);
+        if (method.leadlength <= 0 || method.leadlength > MAX_PLACE_NOTATION_LENGTH)
+            return false;
+
+        for (int pn_i = 0; pn_i < method.leadlength; pn_i++)
+        {
+            const PlaceNotation pn = method.pn[pn_i];
+            leadpn[pn_i] = pn;
+            int index = 0;
+            while (index < changecount && changepn[index] != pn)
+                index++;
+            if (index == changecount)
+            {
+                // past the table, only check that the change is valid; GetChange compiles it when needed
+                if (!CompileChange(method.stage, pn, changecount < MAX_COMPILED_CHANGES ? changes[index] : uncompiled))
+                    return false;
+                if (changecount == MAX_COMPILED_CHANGES)
+                    index = UNCOMPILED_CHANGE;
+                else
+                {
+                    changepn[index] = pn;
+                    changecount++;
+                }
+            }
+            changeindex[pn_i] = index;
+        }
+
+        // GetChange compiles changes past the table at stage
+        stage = method.stage;
+        const RowKernels &stagekernels = GetRowKernels(method.stage);
+        leadhead = Row::Rounds(method.stage);
+        for (int pn_i = 0; pn_i < method.leadlength; pn_i++)
+            stagekernels.applycompiled(leadhead, GetChange(pn_i));
+        if (!leadhead.IsValid())
+        {
+            stage = 0;
+            return false;
+        }
+
+        kernels = &stagekernels;
+        leadlength = method.leadlength;
+        leadcount = method.leadcount;
+        return true;
+    }
+
+    const Change &CompiledMethod::CompileUncompiled(const int pn_i) const
+    {
+        CompileChange(stage, leadpn[pn_i], uncompiled);
+        return uncompiled;
+    }
 }
@@ -8,6 +8,11 @@ namespace ringing
 {
     const int MAX_METHOD_TITLE_LENGTH = 128;
     const int MAX_PLACE_NOTATION_LENGTH = 256;
+    // Most distinct changes in the lead of a method which are compiled ahead; real methods have a
+    // handful, and any more are compiled each time they are needed.
+    const int MAX_COMPILED_CHANGES = 32;
+    // changeindex of a change which isn't in CompiledMethod::changes.
+    const uint8_t UNCOMPILED_CHANGE = 0xFF;
 
     struct Method
     {
@@ -21,6 +26,41 @@ namespace ringing
         inline bool IsHuntBell(ringing::Bell bell) const { return (huntbells & (1 << bell)) != 0; }
         inline int PlainCourseLength() const { return leadlength * leadcount; }
     };
+
+    // The place notation of a method, with each distinct change compiled once.
+    struct CompiledMethod
+    {
+        int stage;
+        int leadlength;
+        int changecount;                                 // number of distinct changes compiled ahead
+        PlaceNotation changepn[MAX_COMPILED_CHANGES];    // place notation of each distinct change
+        Change changes[MAX_COMPILED_CHANGES];            // each distinct change, compiled
+        uint8_t changeindex[MAX_PLACE_NOTATION_LENGTH];  // index into changes of each change in the lead, or UNCOMPILED_CHANGE
+        PlaceNotation leadpn[MAX_PLACE_NOTATION_LENGTH]; // place notation of each change in the lead
+        int leadcount;                                   // number of leads in a plain course
+        Row leadhead;                                    // row at the end of the first lead
+        const RowKernels *kernels;                       // row operations specialised to the stage
+        mutable Change uncompiled;                       // the change GetChange compiled last, if it wasn't in changes
+
+        CompiledMethod() : stage(0), leadlength(0), changecount(0), leadcount(0), kernels(&GetRowKernels(0)) {}
+
+        // Fails if the place notation is invalid.
+        bool Compile(const Method &method);
+        inline bool IsValid() const { return stage > 0 && leadlength > 0; }
+        // The change at pn_i in the lead. Changes past the first MAX_COMPILED_CHANGES distinct ones
+        // are compiled on each call, and only valid until the next call.
+        inline const Change &GetChange(int pn_i) const
+        {
+            const uint8_t index = changeindex[pn_i];
+            return index != UNCOMPILED_CHANGE ? changes[index] : CompileUncompiled(pn_i);
+        }
+        inline int PlainCourseLength() const { return leadlength * leadcount; }
+        // The row at the start of the given lead of the plain course.
+        inline Row LeadHead(int lead) const { return leadhead.Power(lead); }
+
+    private:
+        const Change &CompileUncompiled(int pn_i) const;
+    };
 }
 
 #endif
@@ -0,0 +1,29 @@
+#include "row.hpp"
+#include "packedrow.hpp"
+
+namespace ringing
+{
+    PackedRow::PackedRow(const Row &row) : bits(ROUNDS)
+    {
+        for (int i = 0; i < row.stage; i++)
+        {
+            bits &= ~((uint64_t)0xF << (4 * i));
+            bits |= (uint64_t)row.row[i] << (4 * i);
+        }
+    }
+
+    Row PackedRow::ToRow(const int stage) const
+    {
+        if (stage <= 0 || stage > MAX_BELLS)
+            return Row::Invalid();
+        Row row;
+        row.stage = stage;
+        uint64_t packed = bits;
+        for (int i = 0; i < stage; i++)
+        {
+            row.row[i] = packed & 0xF;
+            packed >>= 4;
+        }
+        return row;
+    }
+}
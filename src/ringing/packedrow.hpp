@@ -0,0 +1,100 @@
+#include "../stdint.h"
+#include "row.hpp"
+
+#if !defined(__sh__) && defined(__SSSE3__) && defined(__x86_64__)
+#include <tmmintrin.h>
+#define RINGING_PACKEDROW_SSSE3
+#endif
+
+#ifndef RINGING_PACKEDROW_HPP
+#define RINGING_PACKEDROW_HPP
+
+namespace ringing
+{
+    static_assert(MAX_BELLS * 4 <= sizeof(uint64_t) * 8, "a packed row must fit in uint64_t");
+
+    // A row stored as one nibble per place (place 0 in the least significant
+    // nibble). Places at or beyond the stage hold their own index, so rows of
+    // every stage share the same rounds and can be multiplied as 16-bell rows.
+    struct PackedRow
+    {
+        static constexpr uint64_t ROUNDS = 0xFEDCBA9876543210ull;
+
+        uint64_t bits;
+
+        PackedRow() : bits(ROUNDS) {}
+        explicit PackedRow(uint64_t bits) : bits(bits) {}
+        explicit PackedRow(const Row &row);
+
+        Row ToRow(int stage) const;
+
+        inline Bell operator[](int place) const { return (bits >> (4 * place)) & 0xF; }
+        inline bool IsRounds() const { return bits == ROUNDS; }
+        inline bool operator==(const PackedRow &other) const { return bits == other.bits; }
+        inline bool operator!=(const PackedRow &other) const { return bits != other.bits; }
+
+        // Transpose this row by another: result[i] = this[other[i]], as Row::operator*.
+        PackedRow operator*(const PackedRow &other) const;
+        PackedRow Inverse() const;
+        // The place of bell, as Inverse()[bell] but without inverting the whole row.
+        inline int PlaceOf(Bell bell) const
+        {
+            // find the lowest zero nibble of bits ^ bell in each nibble; a borrow only
+            // carries up from a zero nibble, so the lowest flagged nibble is exact
+            const uint64_t x = bits ^ (bell * 0x1111111111111111ull);
+            const uint64_t zero = (x - 0x1111111111111111ull) & ~x & 0x8888888888888888ull;
+            return __builtin_ctzll(zero) / 4;
+        }
+        // other^-1 * this * other
+        inline PackedRow Conjugate(const PackedRow &other) const { return other.Inverse() * *this * other; }
+
+        // Fibonacci hashing of the bits, returning the top hashbits bits.
+        inline uint32_t Hash(int hashbits) const
+        {
+            return (uint32_t)((bits * 0x9E3779B97F4A7C15ull) >> (64 - hashbits));
+        }
+    };
+
+#ifdef RINGING_PACKEDROW_SSSE3
+    inline __m128i UnpackNibbles(const uint64_t bits)
+    {
+        const __m128i v = _mm_cvtsi64_si128((long long)bits);
+        const __m128i mask = _mm_set1_epi8(0x0F);
+        const __m128i lo = _mm_and_si128(v, mask);
+        const __m128i hi = _mm_and_si128(_mm_srli_epi16(v, 4), mask);
+        return _mm_unpacklo_epi8(lo, hi);
+    }
+
+    inline uint64_t PackNibbles(const __m128i bytes)
+    {
+        // lo + 16 * hi for each pair of bytes, then narrow to one byte per pair
+        const __m128i pairs = _mm_maddubs_epi16(bytes, _mm_set1_epi16(0x1001));
+        return (uint64_t)_mm_cvtsi128_si64(_mm_packus_epi16(pairs, pairs));
+    }
+
+    inline PackedRow PackedRow::operator*(const PackedRow &other) const
+    {
+        return PackedRow(PackNibbles(_mm_shuffle_epi8(UnpackNibbles(bits), UnpackNibbles(other.bits))));
+    }
+#else
+    // A loop over the nibbles, as for Inverse.
+    inline PackedRow PackedRow::operator*(const PackedRow &other) const
+    {
+        uint64_t product = 0;
+        for (uint64_t i = 0; i < MAX_BELLS; i++)
+            product |= ((bits >> (4 * ((other.bits >> (4 * i)) & 0xF))) & 0xF) << (4 * i);
+        return PackedRow(product);
+    }
+#endif
+
+    // A loop over the nibbles, with shift counts computed as uint64_t so compilers can vectorise it.
+    inline PackedRow PackedRow::Inverse() const
+    {
+        uint64_t inverse = 0;
+        for (uint64_t i = 0; i < MAX_BELLS; i++)
+            inverse |= i << (4 * ((bits >> (4 * i)) & 0xF));
+        return PackedRow(inverse);
+    }
+}
+
+#endif
@@ -2,6 +2,10 @@
 
 namespace ringing
 {
+    const uint64_t FACTORIALS[MAX_BELLS + 1] = {
+        1ull, 1ull, 2ull, 6ull, 24ull, 120ull, 720ull, 5040ull, 40320ull, 362880ull, 3628800ull,
+        39916800ull, 479001600ull, 6227020800ull, 87178291200ull, 1307674368000ull, 20922789888000ull};
+
     bool ParsePlaceNotation(const int stage, const PlaceNotation pn, ChangeDirection *const directions, ChangeDirection *const backdirections, Bell *const bells)
     {
         if (stage > MAX_BELLS)
@@ -48,6 +52,19 @@ namespace ringing
         return true;
     }
 
+    bool CompileChange(const int stage, const PlaceNotation pn, Change &change)
+    {
+        change.stage = 0;
+        if (stage <= 0 || stage > MAX_BELLS)
+            return false;
+        for (Bell i = 0; i < stage; i++)
+            change.source[i] = i;
+        if (!ParsePlaceNotation(stage, pn, change.directions, change.backdirections, change.source))
+            return false;
+        change.stage = stage;
+        return true;
+    }
+
     bool Row::IsRounds() const
     {
         for (int i = 0; i < stage; i++)
@@ -67,16 +84,124 @@ namespace ringing
         return row;
     }
 
+    uint64_t Row::Rank() const
+    {
+        // Lehmer code: digit i counts the unused bells smaller than the bell in place i
+        uint64_t rank = 0;
+        unsigned int used = 0;
+        for (int i = 0; i < stage; i++)
+        {
+            const Bell bell = row[i];
+            const int digit = bell - __builtin_popcount(used & ((1u << bell) - 1));
+            rank += digit * FACTORIALS[stage - 1 - i];
+            used |= 1u << bell;
+        }
+        return rank;
+    }
+
+    Row Row::FromRank(const int stage, uint64_t rank)
+    {
+        if (stage <= 0 || stage > MAX_BELLS || rank >= FACTORIALS[stage])
+            return Invalid();
+        Row row;
+        row.stage = stage;
+        // Unused bells in ascending order, one per nibble
+        uint64_t unused = 0xFEDCBA9876543210ull;
+        for (int i = 0; i < stage; i++)
+        {
+            const uint64_t factorial = FACTORIALS[stage - 1 - i];
+            int digit;
+            if ((rank | factorial) >> 32 == 0)
+            {
+                // avoid 64-bit division where possible
+                digit = (uint32_t)rank / (uint32_t)factorial;
+                rank = (uint32_t)rank % (uint32_t)factorial;
+            }
+            else
+            {
+                digit = rank / factorial;
+                rank %= factorial;
+            }
+            const int shift = 4 * digit;
+            row.row[i] = (unused >> shift) & 0xF;
+            // remove the chosen nibble
+            unused = (unused & ((1ull << shift) - 1)) | ((unused >> shift >> 4) << shift);
+        }
+        return row;
+    }
+
+    Row Row::operator*(const Row &other) const
+    {
+        if (other.stage != this->stage)
+            return Invalid();
+        Row product;
+        product.stage = stage;
+        for (int i = 0; i < stage; i++)
+            product.row[i] = this->row[other.row[i]];
+        return product;
+    }
+
+    Row Row::Power(int n) const
+    {
+        Row result = Rounds(stage);
+        Row square = Row(this);
+        while (n > 0)
+        {
+            if (n & 1)
+                result = result * square;
+            square = square * square;
+            n >>= 1;
+        }
+        return result;
+    }
+
     void Row::ApplyPn(const PlaceNotation pn, ChangeDirection *const directions, ChangeDirection *const backdirections)
     {
         if (!ParsePlaceNotation(this->stage, pn, directions, backdirections, this->row))
             this->Invalidate();
     }
 
+    void Row::ApplyCompiled(const Change &change)
+    {
+        if (change.stage != this->stage)
+        {
+            this->Invalidate();
+            return;
+        }
+        Bell previous[MAX_BELLS];
+        for (int i = 0; i < stage; i++)
+            previous[i] = this->row[i];
+        for (int i = 0; i < stage; i++)
+            this->row[i] = previous[change.source[i]];
+    }
+
     Row Row::AddPn(const PlaceNotation pn, ChangeDirection *const directions, ChangeDirection *const backdirections) const
     {
         Row new_row = Row(this);
         new_row.ApplyPn(pn, directions, backdirections);
         return new_row;
     }
+
+#define STAGE_ROW_KERNELS(kernels) \
+    {&kernels::ApplyCompiled, &kernels::IsRounds, &kernels::ApplyPn}
+
+    const RowKernels ROW_KERNELS[MAX_SPECIALISED_STAGE + 1] = {
+        STAGE_ROW_KERNELS(StageKernels<0>), STAGE_ROW_KERNELS(StageKernels<1>), STAGE_ROW_KERNELS(StageKernels<2>),
+        STAGE_ROW_KERNELS(StageKernels<3>), STAGE_ROW_KERNELS(StageKernels<4>), STAGE_ROW_KERNELS(StageKernels<5>),
+        STAGE_ROW_KERNELS(StageKernels<6>), STAGE_ROW_KERNELS(StageKernels<7>), STAGE_ROW_KERNELS(StageKernels<8>),
+        STAGE_ROW_KERNELS(StageKernels<9>), STAGE_ROW_KERNELS(StageKernels<10>), STAGE_ROW_KERNELS(StageKernels<11>),
+        STAGE_ROW_KERNELS(StageKernels<12>)};
+    static_assert(MAX_SPECIALISED_STAGE == 12, "ROW_KERNELS must have an entry for every specialised stage");
+    const RowKernels GENERIC_ROW_KERNELS = STAGE_ROW_KERNELS(GenericKernels);
+
+#undef STAGE_ROW_KERNELS
+
+    const RowKernels &GetRowKernels(const int stage)
+    {
+        if (stage < 0 || stage > MAX_BELLS)
+            return ROW_KERNELS[0];
+        if (stage > MAX_SPECIALISED_STAGE)
+            return GENERIC_ROW_KERNELS;
+        return ROW_KERNELS[stage];
+    }
 }
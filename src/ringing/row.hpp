@@ -7,12 +7,15 @@ namespace ringing
 {
     const int MAX_BELLS = 16;
 
+    // FACTORIALS[n] == n!, the number of rows on n bells
+    extern const uint64_t FACTORIALS[MAX_BELLS + 1];
+
     typedef uint16_t BellBitmask;
     static_assert(MAX_BELLS <= sizeof(BellBitmask) * 8, "MAX_BELLS must fit in BellBitmask");
     typedef BellBitmask PlaceNotation;
     typedef uint8_t Bell;
 
-    enum ChangeDirection : int
+    enum ChangeDirection : signed char
     {
         Down = -1,
         Place = 0,
@@ -21,6 +24,20 @@ namespace ringing
 
     bool ParsePlaceNotation(int stage, PlaceNotation pn, ChangeDirection *directions = nullptr, ChangeDirection *backdirections = nullptr, Bell *bells = nullptr);
 
+    // A place notation parsed once into a permutation, so it can be applied
+    // to a row with a single table lookup per bell.
+    struct Change
+    {
+        int stage;                                 // 0 if the place notation was invalid
+        Bell source[MAX_BELLS];                    // source[i] is the place the bell moving into place i came from
+        ChangeDirection directions[MAX_BELLS];     // direction the bell in place i moves next
+        ChangeDirection backdirections[MAX_BELLS]; // direction the bell now in place i came from
+
+        inline bool IsValid() const { return stage > 0; }
+    };
+
+    bool CompileChange(int stage, PlaceNotation pn, Change &change);
+
     struct Row
     {
         int stage;
@@ -46,9 +63,111 @@ namespace ringing
         inline bool IsValid() const { return stage > 0; }
         bool IsRounds() const;
 
+        // Index of the row in lexicographic order of all rows of its stage, in [0, stage!).
+        uint64_t Rank() const;
+        static Row FromRank(int stage, uint64_t rank);
+
+        // Transpose this row by another: result[i] = this[other[i]].
+        Row operator*(const Row &other) const;
+        // This row transposed by itself n times; rounds for n == 0.
+        Row Power(int n) const;
+
         void ApplyPn(PlaceNotation pn, ChangeDirection *directions = nullptr, ChangeDirection *backdirections = nullptr);
         Row AddPn(PlaceNotation pn, ChangeDirection *directions = nullptr, ChangeDirection *backdirections = nullptr) const;
+        void ApplyCompiled(const Change &change);
     };
+
+    // Stages which get StageKernels of their own. Above this, unrolling no longer pays for the code it
+    // adds, and the generic Row methods are used instead.
+    const int MAX_SPECIALISED_STAGE = 12;
+
+    // Row operations for a stage fixed at compile time, so that loops unroll.
+    template <int Stage>
+    struct StageKernels
+    {
+        static_assert(0 <= Stage && Stage <= MAX_BELLS, "Stage out of range");
+
+        static void ApplyCompiled(Row &row, const Change &change)
+        {
+            if (row.stage != Stage || change.stage != Stage)
+            {
+                row.Invalidate();
+                return;
+            }
+            Bell previous[MAX_BELLS];
+            for (int i = 0; i < Stage; i++)
+                previous[i] = row.row[i];
+            for (int i = 0; i < Stage; i++)
+                row.row[i] = previous[change.source[i]];
+        }
+
+        static bool IsRounds(const Row &row)
+        {
+            bool rounds = row.stage == Stage;
+            for (int i = 0; i < Stage; i++)
+                rounds &= row.row[i] == i;
+            return rounds;
+        }
+
+        static void ApplyPn(Row &row, const PlaceNotation pn, ChangeDirection *const backdirections = nullptr)
+        {
+            if (row.stage != Stage)
+            {
+                row.Invalidate();
+                return;
+            }
+            bool swap_prev = false;
+            for (int i = 0; i < Stage; i++)
+            {
+                const bool swap_cur = (pn & (1 << i)) == 0;
+                if (swap_prev)
+                {
+                    if (!swap_cur)
+                    {
+                        row.Invalidate();
+                        return;
+                    }
+                    const Bell temp = row.row[i - 1];
+                    row.row[i - 1] = row.row[i];
+                    row.row[i] = temp;
+                    if (backdirections != nullptr)
+                    {
+                        backdirections[i] = ChangeDirection::Up;
+                        backdirections[i - 1] = ChangeDirection::Down;
+                    }
+                    swap_prev = false;
+                }
+                else if (swap_cur)
+                    swap_prev = true;
+                else if (backdirections != nullptr)
+                    backdirections[i] = ChangeDirection::Place;
+            }
+            if (swap_prev)
+                row.Invalidate();
+        }
+    };
+
+    // The generic Row methods in the form of StageKernels, for stages above MAX_SPECIALISED_STAGE.
+    struct GenericKernels
+    {
+        static void ApplyCompiled(Row &row, const Change &change) { row.ApplyCompiled(change); }
+        static bool IsRounds(const Row &row) { return row.IsRounds(); }
+        static void ApplyPn(Row &row, const PlaceNotation pn, ChangeDirection *const backdirections = nullptr)
+        {
+            row.ApplyPn(pn, nullptr, backdirections);
+        }
+    };
+
+    // StageKernels for a stage chosen at runtime, looked up once per method.
+    struct RowKernels
+    {
+        void (*applycompiled)(Row &row, const Change &change);
+        bool (*isrounds)(const Row &row);
+        void (*applypn)(Row &row, PlaceNotation pn, ChangeDirection *backdirections);
+    };
+
+    // Out of range stages get the stage 0 kernels, matching the generic Row methods on an invalid row.
+    const RowKernels &GetRowKernels(int stage);
 }
 
 #endif
@@ -0,0 +1,127 @@
+#include "row.hpp"
+#include "method.hpp"
+#include "touch.hpp"
+
+namespace ringing
+{
+    bool Touch::SetMethod(const CompiledMethod &method)
+    {
+        this->method = nullptr;
+        callcount = 0;
+        leadcount = 0;
+        if (!method.IsValid())
+            return false;
+        this->method = &method;
+        leadtranspositions[0] = method.leadhead;
+        return true;
+    }
+
+    bool Touch::AddCall(const Call &call)
+    {
+        if (method == nullptr || callcount >= MAX_CALLS)
+            return false;
+        if (call.length <= 0 || call.length > MAX_CALL_LENGTH || call.length > method->leadlength)
+            return false;
+        if (call.symbol == PLAIN_LEAD_SYMBOL || call.symbol == '.' || call.symbol == ' ')
+            return false;
+
+        const int callstart = method->leadlength - call.length;
+        Row row = Row::Rounds(method->stage);
+        for (int pn_i = 0; pn_i < callstart; pn_i++)
+            row.ApplyCompiled(method->GetChange(pn_i));
+        for (int i = 0; i < call.length; i++)
+        {
+            if (!CompileChange(method->stage, call.pn[i], callchanges[callcount][i]))
+                return false;
+            row.ApplyCompiled(callchanges[callcount][i]);
+        }
+
+        calls[callcount] = call;
+        leadtranspositions[++callcount] = row;
+        return true;
+    }
+
+    bool Touch::SetCalling(const char *calling)
+    {
+        leadcount = 0;
+        if (method == nullptr || calling == nullptr)
+            return false;
+        for (; *calling != 0; calling++)
+        {
+            const char symbol = *calling;
+            if (symbol == ' ')
+                continue;
+            if (leadcount >= MAX_TOUCH_LEADS)
+            {
+                leadcount = 0;
+                return false;
+            }
+
+            int leadcall = -1;
+            if (symbol == PLAIN_LEAD_SYMBOL || symbol == '.')
+                leadcall = 0;
+            for (int call = 0; call < callcount && leadcall < 0; call++)
+                if (calls[call].symbol == symbol)
+                    leadcall = call + 1;
+            if (leadcall < 0)
+            {
+                leadcount = 0;
+                return false;
+            }
+            leadcalls[leadcount++] = leadcall;
+        }
+        return leadcount > 0;
+    }
+
+    const Change &Touch::GetChange(const int lead, const int pn_i) const
+    {
+        const int leadcall = leadcalls[lead];
+        if (leadcall != 0)
+        {
+            const int callstart = method->leadlength - calls[leadcall - 1].length;
+            if (pn_i >= callstart)
+                return callchanges[leadcall - 1][pn_i - callstart];
+        }
+        return method->GetChange(pn_i);
+    }
+
+    Row Touch::LeadHead(const int lead) const
+    {
+        Row row = Row::Rounds(method->stage);
+        for (int i = 0; i < lead && i < leadcount; i++)
+            row = row * leadtranspositions[leadcalls[i]];
+        return row;
+    }
+
+    void TouchRowStream::Restart(const int lead)
+    {
+        this->lead = lead;
+        pn_i = 0;
+        started = false;
+    }
+
+    bool TouchRowStream::Next(Row &row, const ChangeDirection *&backdirections)
+    {
+        if (!started)
+        {
+            started = true;
+            this->row = touch->LeadHead(lead);
+            backdirections = nullptr;
+        }
+        else
+        {
+            if (lead >= touch->LeadCount())
+                return false;
+            const Change &change = touch->GetChange(lead, pn_i++);
+            touch->Kernels().applycompiled(this->row, change);
+            backdirections = change.backdirections;
+            if (pn_i >= touch->LeadLength())
+            {
+                pn_i = 0;
+                lead++;
+            }
+        }
+        row = this->row;
+        return true;
+    }
+}
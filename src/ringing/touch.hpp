@@ -0,0 +1,92 @@
+#include "../stdint.h"
+#include "row.hpp"
+#include "method.hpp"
+
+#ifndef RINGING_TOUCH_HPP
+#define RINGING_TOUCH_HPP
+
+namespace ringing
+{
+    const int MAX_CALL_LENGTH = 4;
+    const int MAX_CALLS = 4;
+    const int MAX_TOUCH_LEADS = 512;
+
+    const char PLAIN_LEAD_SYMBOL = 'p';
+
+    // A call, e.g. a bob or single, replacing the place notation at the end of a lead.
+    struct Call
+    {
+        char symbol;                       // character used for the call in a calling
+        int length;                        // number of changes replaced at the end of the lead
+        PlaceNotation pn[MAX_CALL_LENGTH]; // place notation used instead
+    };
+
+    // A method rung with a calling, one symbol per lead.
+    class Touch
+    {
+    private:
+        const CompiledMethod *method;
+        int callcount;
+        Call calls[MAX_CALLS];
+        Change callchanges[MAX_CALLS][MAX_CALL_LENGTH];
+        Row leadtranspositions[MAX_CALLS + 1]; // row after a plain (0) or called (call + 1) lead from rounds
+        int leadcount;
+        uint8_t leadcalls[MAX_TOUCH_LEADS]; // 0 for a plain lead, otherwise call + 1
+
+    public:
+        Touch() : method(nullptr), callcount(0), leadcount(0) {}
+
+        // Clears the calls and calling.
+        bool SetMethod(const CompiledMethod &method);
+        bool AddCall(const Call &call);
+        // Each character is a call symbol, PLAIN_LEAD_SYMBOL or '.' for a plain lead; spaces are ignored.
+        bool SetCalling(const char *calling);
+
+        inline bool IsValid() const { return method != nullptr && leadcount > 0; }
+        inline int Stage() const { return method->stage; }
+        inline const RowKernels &Kernels() const { return *method->kernels; }
+        inline int LeadCount() const { return leadcount; }
+        inline int LeadLength() const { return method->leadlength; }
+        inline int ChangeCount() const { return leadcount * method->leadlength; }
+        // The symbol of the call at the end of the lead, or PLAIN_LEAD_SYMBOL.
+        inline char GetCallSymbol(int lead) const
+        {
+            return leadcalls[lead] == 0 ? PLAIN_LEAD_SYMBOL : calls[leadcalls[lead] - 1].symbol;
+        }
+
+        const Change &GetChange(int lead, int pn_i) const;
+        // The row at the start of the given lead, found by composing lead transpositions.
+        Row LeadHead(int lead) const;
+    };
+
+    // Generates the rows of a touch one at a time, starting with rounds.
+    class TouchRowStream
+    {
+    private:
+        const Touch *touch;
+        int lead;
+        int pn_i;
+        Row row;
+        bool started;
+
+    public:
+        TouchRowStream(const Touch &touch) : touch(&touch) { Restart(); }
+
+        // Restart at the lead head of the given lead, without generating earlier rows.
+        void Restart(int lead = 0);
+        inline bool IsValid() const { return touch->IsValid(); }
+        inline int Stage() const { return touch->Stage(); }
+        inline int ChangeCount() const { return touch->ChangeCount(); }
+
+        // Writes the next row; returns false after the last row.
+        inline bool Next(Row &row)
+        {
+            const ChangeDirection *backdirections;
+            return Next(row, backdirections);
+        }
+        // As Next(row), also giving the directions each bell came from (nullptr for the first row).
+        bool Next(Row &row, const ChangeDirection *&backdirections);
+    };
+}
+
+#endif
@@ -0,0 +1,185 @@
+#include "row.hpp"
+#include "method.hpp"
+#include "packedrow.hpp"
+#include "touch.hpp"
+#include "truth.hpp"
+
+namespace ringing
+{
+    LeadRowStream::LeadRowStream(const CompiledMethod *const leads[], const int leadcount)
+        : leads(leads), single(nullptr), leadcount(leadcount)
+    {
+        Restart();
+    }
+
+    LeadRowStream::LeadRowStream(const CompiledMethod &method, const int leadcount)
+        : leads(nullptr), single(&method), leadcount(leadcount)
+    {
+        Restart();
+    }
+
+    void LeadRowStream::Restart()
+    {
+        lead = 0;
+        pn_i = 0;
+        started = false;
+    }
+
+    int LeadRowStream::ChangeCount() const
+    {
+        if (leads == nullptr)
+            return single->leadlength * leadcount;
+        int count = 0;
+        for (int i = 0; i < leadcount; i++)
+            count += leads[i]->leadlength;
+        return count;
+    }
+
+    bool LeadRowStream::Next(Row &row)
+    {
+        if (!started)
+        {
+            started = true;
+            this->row = Row::Rounds(Stage());
+        }
+        else
+        {
+            if (lead >= leadcount)
+                return false;
+            const CompiledMethod &method = GetLead(lead);
+            method.kernels->applycompiled(this->row, method.GetChange(pn_i++));
+            if (pn_i >= method.leadlength)
+            {
+                pn_i = 0;
+                lead++;
+            }
+        }
+        row = this->row;
+        return true;
+    }
+
+    bool TruthProver::Reset(const int stage, const int expectedrows)
+    {
+        this->stage = stage;
+        rowcount = 0;
+        if (stage <= 0 || stage > MAX_BELLS)
+            return false;
+        if (stage <= MAX_DENSE_TRUTH_STAGE)
+        {
+            hashbits = 0;
+            const int rows = FACTORIALS[stage];
+            for (int i = 0; i < (rows + 7) / 8; i++)
+                bitset[i] = 0;
+            return true;
+        }
+        if (expectedrows > MAX_TRUTH_HASHED_ROWS)
+            return false;
+        hashbits = 6;
+        while ((1 << hashbits) / 4 * 3 < expectedrows)
+            hashbits++;
+        for (int i = 0; i < 1 << hashbits; i++)
+            table[i].bits = 0;
+        return true;
+    }
+
+    bool TruthProver::Insert(const Row &row)
+    {
+        if (hashbits == 0)
+        {
+            const int rank = row.Rank();
+            const uint8_t bit = 1 << (rank & 7);
+            if (bitset[rank >> 3] & bit)
+                return false;
+            bitset[rank >> 3] |= bit;
+        }
+        else
+        {
+            const PackedRow packed = PackedRow(row);
+            const uint32_t mask = (1u << hashbits) - 1;
+            uint32_t slot = packed.Hash(hashbits);
+            while (table[slot].bits != 0)
+            {
+                if (table[slot] == packed)
+                    return false;
+                slot = (slot + 1) & mask;
+            }
+            table[slot] = packed;
+        }
+        rowcount++;
+        return true;
+    }
+
+    template <typename Stream>
+    TruthResult TruthProver::Prove(Stream &stream)
+    {
+        TruthResult result = {TruthStatus::Proved, 0, -1, -1, PackedRow()};
+        stream.Restart();
+        if (!stream.IsValid())
+        {
+            result.status = TruthStatus::InvalidRows;
+            return result;
+        }
+        // The final row is not checked if it is rounds, as that is the touch coming round
+        const int lastindex = stream.ChangeCount();
+        if (!Reset(stream.Stage(), lastindex + 1))
+        {
+            result.status = TruthStatus::TooLong;
+            return result;
+        }
+
+        Row row;
+        int index = 0;
+        for (; stream.Next(row); index++)
+        {
+            if (!row.IsValid())
+            {
+                result.status = TruthStatus::InvalidRows;
+                break;
+            }
+            if (index == lastindex && row.IsRounds())
+                break;
+            if (!Insert(row))
+            {
+                result.status = TruthStatus::Repeated;
+                result.repeatindex = index;
+                result.row = PackedRow(row);
+                break;
+            }
+        }
+        result.rowcount = rowcount;
+
+        if (result.status == TruthStatus::Repeated)
+        {
+            // Find the earlier occurrence by streaming the rows again
+            stream.Restart();
+            for (index = 0; stream.Next(row) && index < result.repeatindex; index++)
+                if (PackedRow(row) == result.row)
+                {
+                    result.firstindex = index;
+                    break;
+                }
+        }
+        return result;
+    }
+
+    template TruthResult TruthProver::Prove<LeadRowStream>(LeadRowStream &stream);
+    template TruthResult TruthProver::Prove<TouchRowStream>(TouchRowStream &stream);
+
+    TruthResult ProveCourse(TruthProver &prover, const CompiledMethod &method)
+    {
+        LeadRowStream stream = LeadRowStream(method, method.leadcount);
+        return prover.Prove(stream);
+    }
+
+    TruthResult ProveLeads(TruthProver &prover, const CompiledMethod *const leads[], const int leadcount)
+    {
+        LeadRowStream stream = LeadRowStream(leads, leadcount);
+        return prover.Prove(stream);
+    }
+
+    TruthResult ProveTouch(TruthProver &prover, const Touch &touch)
+    {
+        TouchRowStream stream = TouchRowStream(touch);
+        return prover.Prove(stream);
+    }
+}
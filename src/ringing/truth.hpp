@@ -0,0 +1,92 @@
+#include "../stdint.h"
+#include "row.hpp"
+#include "method.hpp"
+#include "packedrow.hpp"
+#include "touch.hpp"
+
+#ifndef RINGING_TRUTH_HPP
+#define RINGING_TRUTH_HPP
+
+namespace ringing
+{
+    // Stages up to this are proved with a bitset indexed by permutation rank.
+    const int MAX_DENSE_TRUTH_STAGE = 8;
+    const int DENSE_TRUTH_ROWS = 40320; // 8!
+    // Larger stages are proved with an open-addressing hash set of packed rows.
+    const int TRUTH_HASH_BITS = 14;
+    const int TRUTH_HASH_CAPACITY = 1 << TRUTH_HASH_BITS;
+    const int MAX_TRUTH_HASHED_ROWS = TRUTH_HASH_CAPACITY / 4 * 3;
+
+    enum TruthStatus : char
+    {
+        Proved = 0,      // no row repeats
+        Repeated = 1,    // a row repeats
+        TooLong = 2,     // too many rows to prove
+        InvalidRows = 3, // empty input or invalid place notation
+    };
+
+    struct TruthResult
+    {
+        TruthStatus status;
+        int rowcount;    // rows checked
+        int repeatindex; // index of the first row that repeats an earlier row, or -1
+        int firstindex;  // index of the earlier occurrence of that row, or -1
+        PackedRow row;   // the repeated row
+    };
+
+    // Streams the rows of a sequence of leads, starting with rounds.
+    class LeadRowStream
+    {
+    private:
+        const CompiledMethod *const *leads; // nullptr to repeat single
+        const CompiledMethod *single;
+        int leadcount;
+        int lead;
+        int pn_i;
+        Row row;
+        bool started;
+
+        inline const CompiledMethod &GetLead(int index) const { return leads != nullptr ? *leads[index] : *single; }
+
+    public:
+        LeadRowStream(const CompiledMethod *const leads[], int leadcount);
+        LeadRowStream(const CompiledMethod &method, int leadcount);
+
+        void Restart();
+        inline bool IsValid() const { return leadcount > 0 && GetLead(0).IsValid(); }
+        inline int Stage() const { return GetLead(0).stage; }
+        // Total number of changes in all leads; one fewer than the number of rows.
+        int ChangeCount() const;
+        // Writes the next row; returns false after the last row.
+        bool Next(Row &row);
+    };
+
+    // The set of rows seen so far.
+    class TruthProver
+    {
+    private:
+        int stage;
+        int rowcount;
+        int hashbits; // 0 when using the dense bitset
+        uint8_t bitset[DENSE_TRUTH_ROWS / 8];
+        PackedRow table[TRUTH_HASH_CAPACITY]; // empty slots hold zero bits
+
+    public:
+        // Prepare for up to expectedrows rows of the given stage.
+        bool Reset(int stage, int expectedrows);
+        inline int RowCount() const { return rowcount; }
+
+        // Returns false if the row had already been inserted.
+        bool Insert(const Row &row);
+
+        // Stream is LeadRowStream or TouchRowStream.
+        template <typename Stream>
+        TruthResult Prove(Stream &stream);
+    };
+
+    TruthResult ProveCourse(TruthProver &prover, const CompiledMethod &method);
+    TruthResult ProveLeads(TruthProver &prover, const CompiledMethod *const leads[], int leadcount);
+    TruthResult ProveTouch(TruthProver &prover, const Touch &touch);
+}
+
+#endif
@@ -10,6 +10,8 @@
 class MethodScreen
 {
     ringing::Method method;
+    ringing::CompiledMethod compiled;
+    ringing::CourseCache course; // falls back to rendering from compiled if the course is too long
     static const int border = 3;
     static const int topborder = 7; // extra space under the title
 
@@ -55,7 +57,10 @@ class MethodScreen
     {
         int x = methodXOffset + methodrender::RowWidth / 2;
 
-        methodrender::PrintMethod(x, methodYOffset, method, styles);
+        if (course.IsValid())
+            methodrender::PrintCourse(x, methodYOffset, course, styles);
+        else
+            methodrender::PrintMethod(x, methodYOffset, compiled, styles);
     }
 
     void ResetStyles()
@@ -194,11 +199,26 @@ public:
 
     bool ReadMethodFrom(ringing::FileReader &mf)
     {
-        return mf.ReadMethod(method);
+        if (!mf.ReadMethod(method))
+            return false;
+        return Prepare();
     }
 
-    void CopyMethodFrom(const ringing::Method &method)
+    bool CopyMethodFrom(const ringing::Method &method)
     {
         this->method = method;
+        return Prepare();
+    }
+
+private:
+    bool Prepare()
+    {
+        if (!compiled.Compile(method))
+        {
+            course.Clear();
+            return false;
+        }
+        course.Build(compiled);
+        return true;
     }
 };
@@ -18,6 +18,8 @@ struct SearchResult
 
     // position in the method file, or -1 for empty result
     int file_pos;
+    // stage of the method, when searching every stage
+    int stage;
     // (cropped) title of the method
     charset::MBChar title[MAX_DISPLAY_METHOD_TITLE_BYTES + 1];
 
@@ -43,6 +45,67 @@ class SearchScreen
     // position in the file of the start of each page, or 0 for unset, or -1 for end of results
     int file_page_positions[MAX_SEARCH_PAGES + 1] = {0};
     int search_pages;
+    // position in the file of the first method after the results, or -1 if not yet found
+    int results_end;
+
+    // If the file has an index, results are found by their ordinals in it instead of
+    // by the pages above: any page can be read directly, and there is no page limit.
+    bool ordinal_search;
+    int first_ordinal; // ordinal of the first result
+    int result_count;
+
+    enum class SearchMode
+    {
+        Prefix, // titles starting with search_text
+        // Titles containing search_text anywhere. The results are found page by page from the index,
+        // so the pages above hold the ordinal to start searching from for each page instead of its position.
+        Infix,
+        // Titles starting with a few edits of search_text, closest first; only the closest are found.
+        Fuzzy,
+        // Titles starting with search_text on every stage of the library, in title order. The results of
+        // each stage are a range of ordinals, merged a page at a time forwards or backwards from the
+        // selected page, so any page can be reached without the pages above.
+        AllStages,
+    };
+    SearchMode search_mode;
+    static const int MAX_FUZZY_RESULTS = 3 * MAX_SEARCH_RESULTS_PER_PAGE;
+    int fuzzy_ordinals[MAX_FUZZY_RESULTS];
+    int fuzzy_distances[MAX_FUZZY_RESULTS];
+
+    // The results on each stage, or none if the library doesn't have it
+    int stage_first_ordinals[STAGES_COUNT];
+    int stage_result_counts[STAGES_COUNT];
+    // Ordinal of the first result of each stage on or after the start of merge_page
+    int merge_page_ordinals[STAGES_COUNT];
+    int merge_page;
+    // The next result of each stage, with a heap of the stages ordered by its title,
+    // or the previous result of each stage, latest first, when stepping back a page
+    struct MergeHead
+    {
+        int file_pos;
+        charset::MBChar title[ringing::MAX_METHOD_TITLE_LENGTH];
+    };
+    MergeHead merge_heads[STAGES_COUNT];
+    int merge_heap[STAGES_COUNT];
+    int merge_heap_size;
+    bool merge_backwards;
+
+    // The search for each shorter prefix of search_text, so that deleting a character restores it
+    struct SearchLevel
+    {
+        int file_page_positions[MAX_SEARCH_PAGES + 1];
+        int search_pages;
+        int results_end;
+        int first_ordinal;
+        int result_count;
+        bool saved; // false once the search has changed mode since the level was saved
+    };
+    SearchLevel levels[MAX_SEARCH_LENGTH];
+    // Methods to scan forward from the previous results for a longer search before searching afresh
+    static const int MAX_REFINE_SCAN = 2 * MAX_SEARCH_RESULTS_PER_PAGE;
+    // Shorter searches anywhere in titles have no trigrams to look up, so would read every title;
+    // they find nothing until they are this long.
+    static const int MIN_INFIX_SEARCH_LENGTH = 3;
 
     static const int font_width = 18;
     static const int font_height = 24;
@@ -65,14 +128,24 @@ class SearchScreen
     void DrawResults() const
     {
         int hx = left;
-        PrintCXY(hx, top, "< ", TEXT_MODE_NORMAL, -1,
-                 cur_stage_index == 0 ? fg_paleheaderarrow : fg_headerarrow, bg_header, 1, 0);
-        hx += 2 * font_width;
-        PrintCXY(hx, top, STAGE_HEADERS[cur_stage_index], TEXT_MODE_NORMAL, -1,
-                 fg_header, bg_header, 1, 0);
-        hx += MB_ElementCount((char *)STAGE_HEADERS[cur_stage_index]) * font_width;
-        PrintCXY(hx, top, " >", TEXT_MODE_NORMAL, -1,
-                 cur_stage_index == STAGES_COUNT - 1 ? fg_paleheaderarrow : fg_headerarrow, bg_header, 1, 0);
+        if (search_mode == SearchMode::AllStages)
+            PrintCXY(hx, top, "All stages", TEXT_MODE_NORMAL, -1, fg_header, bg_header, 1, 0);
+        else
+        {
+            PrintCXY(hx, top, "< ", TEXT_MODE_NORMAL, -1,
+                     cur_stage_index == 0 ? fg_paleheaderarrow : fg_headerarrow, bg_header, 1, 0);
+            hx += 2 * font_width;
+            PrintCXY(hx, top, STAGE_HEADERS[cur_stage_index], TEXT_MODE_NORMAL, -1,
+                     fg_header, bg_header, 1, 0);
+            hx += MB_ElementCount((char *)STAGE_HEADERS[cur_stage_index]) * font_width;
+            PrintCXY(hx, top, " >", TEXT_MODE_NORMAL, -1,
+                     cur_stage_index == STAGES_COUNT - 1 ? fg_paleheaderarrow : fg_headerarrow, bg_header, 1, 0);
+            hx += 2 * font_width;
+        }
+        if (search_mode == SearchMode::Infix)
+            PrintCXY(hx, top, " *", TEXT_MODE_NORMAL, -1, fg_header, bg_header, 1, 0);
+        else if (search_mode == SearchMode::Fuzzy)
+            PrintCXY(hx, top, " ~", TEXT_MODE_NORMAL, -1, fg_header, bg_header, 1, 0);
 
         if (!good_read)
         {
@@ -105,7 +178,8 @@ class SearchScreen
             color_t bg = result_index == selected_result ? bg_selected : bg_default;
 
             trueprefixlength = {0, 0};
-            if (prefixlength > 0)
+            // other matches don't have the search to highlight
+            if (prefixlength > 0 && (search_mode == SearchMode::Prefix || search_mode == SearchMode::AllStages))
             {
                 trueprefixlength =
                     charset::CopyString(result.title, buf, prefixlength,
@@ -136,12 +210,16 @@ class SearchScreen
 
     void Prepare()
     {
-        if (!good_read || new_stage_index != cur_stage_index)
+        // the reader is left on another stage after loading a method found on every stage
+        if (!good_read || new_stage_index != cur_stage_index || mf->GetStage() != STAGES[new_stage_index])
         {
             good_read = mf != nullptr;
             if (good_read)
                 LoadMethodFile(*mf, STAGES[new_stage_index]);
             cur_stage_index = new_stage_index;
+            ordinal_search = good_read && mf->HasIndex();
+            if (!ordinal_search) // other modes need the index
+                search_mode = SearchMode::Prefix;
         }
 
         search_text[0] = 0;
@@ -155,8 +233,16 @@ class SearchScreen
 
     bool ReadPageEntries()
     {
+        if (search_mode == SearchMode::Infix)
+            return ReadInfixPageEntries();
+        if (search_mode == SearchMode::AllStages)
+            return ReadMergedPageEntries();
+        if (ordinal_search) // including fuzzy results, which are ordinals too
+            return ReadOrdinalPageEntries();
         mf->Seek(file_page_positions[selected_page]);
         bool end_of_results = false;
+        charset::NonMBChar search_key[MAX_SEARCH_LENGTH + 1];
+        charset::NormaliseSearch(search_text, search_key, MAX_SEARCH_LENGTH);
         charset::MBChar title[ringing::MAX_METHOD_TITLE_LENGTH];
         for (int i = 0; i < MAX_SEARCH_RESULTS_PER_PAGE; i++)
         {
@@ -168,8 +254,10 @@ class SearchScreen
 
             int pos;
             bool goodread = mf->ReadMethodSummary(&pos, nullptr, title);
-            if (!goodread || charset::CompareSearch(search_text, title) != charset::CompareResult::Contained)
+            if (!goodread || charset::CompareNormalisedSearch(search_key, title) != charset::CompareResult::Contained)
             {
+                if (goodread)
+                    results_end = pos;
                 end_of_results = true;
                 results[i].file_pos = -1;
                 continue;
@@ -180,19 +268,255 @@ class SearchScreen
                                 SearchResult::MAX_DISPLAY_METHOD_TITLE_BYTES, true);
 
             if (mf->EndOfFile())
+            {
+                results_end = mf->Tell();
                 end_of_results = true;
+            }
         }
         file_page_positions[selected_page + 1] = end_of_results ? -1 : mf->Tell();
         return end_of_results;
     }
 
-    bool Search()
+    bool ReadOrdinalPageEntries()
+    {
+        const int start = selected_page * MAX_SEARCH_RESULTS_PER_PAGE;
+        const bool fuzzy = search_mode == SearchMode::Fuzzy; // fuzzy results aren't consecutive
+        int remaining = result_count - start;
+        if (remaining > 0 && !fuzzy && !mf->SeekOrdinal(first_ordinal + start))
+            remaining = 0;
+        charset::MBChar title[ringing::MAX_METHOD_TITLE_LENGTH];
+        for (int i = 0; i < MAX_SEARCH_RESULTS_PER_PAGE; i++)
+        {
+            int pos;
+            if (i >= remaining || (fuzzy && !mf->SeekOrdinal(fuzzy_ordinals[start + i])) ||
+                !mf->ReadMethodSummary(&pos, nullptr, title))
+            {
+                remaining = i;
+                results[i].file_pos = -1;
+                continue;
+            }
+            results[i].file_pos = pos;
+            charset::CopyString(title, results[i].title,
+                                SearchResult::MAX_DISPLAY_METHOD_TITLE_CHARS,
+                                SearchResult::MAX_DISPLAY_METHOD_TITLE_BYTES, true);
+        }
+        return start + MAX_SEARCH_RESULTS_PER_PAGE >= result_count;
+    }
+
+    bool ReadInfixPageEntries()
+    {
+        // one more than a page, to find where the next page starts
+        int ordinals[MAX_SEARCH_RESULTS_PER_PAGE + 1];
+        int count = 0;
+        const bool too_short = search_cursor > 0 && search_cursor < MIN_INFIX_SEARCH_LENGTH;
+        if (too_short || !mf->SearchInfix(search_text, file_page_positions[selected_page], ordinals,
+                                          MAX_SEARCH_RESULTS_PER_PAGE + 1, count))
+            count = 0;
+        if (count > 0)
+            file_page_positions[selected_page] = ordinals[0]; // skip the non-matches before it next time
+        charset::MBChar title[ringing::MAX_METHOD_TITLE_LENGTH];
+        for (int i = 0; i < MAX_SEARCH_RESULTS_PER_PAGE; i++)
+        {
+            int pos;
+            if (i >= count || !mf->SeekOrdinal(ordinals[i]) || !mf->ReadMethodSummary(&pos, nullptr, title))
+            {
+                count = i;
+                results[i].file_pos = -1;
+                continue;
+            }
+            results[i].file_pos = pos;
+            charset::CopyString(title, results[i].title,
+                                SearchResult::MAX_DISPLAY_METHOD_TITLE_CHARS,
+                                SearchResult::MAX_DISPLAY_METHOD_TITLE_BYTES, true);
+        }
+        const bool end_of_results = count <= MAX_SEARCH_RESULTS_PER_PAGE;
+        file_page_positions[selected_page + 1] = end_of_results ? -1 : ordinals[MAX_SEARCH_RESULTS_PER_PAGE];
+        return end_of_results;
+    }
+
+    // Whether the next result of stage index a comes before that of b.
+    bool MergeHeadBefore(const int a, const int b) const
+    {
+        const int order = charset::CompareTitles(merge_heads[a].title, merge_heads[b].title);
+        return order < 0 || (order == 0 && a < b);
+    }
+
+    // Whether the head of stage index a is merged before that of b, in the direction of the merge.
+    bool MergeHeadFirst(const int a, const int b) const
+    {
+        return merge_backwards ? MergeHeadBefore(b, a) : MergeHeadBefore(a, b);
+    }
+
+    // Read the result of stage index i with the given ordinal into the heap. If it can't be read, the
+    // stage's results end before it, and the count of results drops to match.
+    bool PushMergeHead(const int i, const int ordinal)
+    {
+        MergeHead &head = merge_heads[i];
+        // selecting the stage again would throw away the title decoder's place in it
+        if ((mf->GetStage() != STAGES[i] && !mf->SelectStage(STAGES[i])) || !mf->SeekOrdinal(ordinal) ||
+            !mf->ReadMethodSummary(&head.file_pos, nullptr, head.title))
+        {
+            const int readable = ordinal - stage_first_ordinals[i];
+            if (readable < stage_result_counts[i])
+            {
+                result_count -= stage_result_counts[i] - readable;
+                stage_result_counts[i] = readable;
+                search_pages = OrdinalPageCount();
+            }
+            return false;
+        }
+        int child = merge_heap_size++;
+        for (; child > 0 && MergeHeadFirst(i, merge_heap[(child - 1) / 2]); child = (child - 1) / 2)
+            merge_heap[child] = merge_heap[(child - 1) / 2];
+        merge_heap[child] = i;
+        return true;
+    }
+
+    // Remove the stage index with the first result from the heap.
+    int PopMergeHead()
+    {
+        const int first = merge_heap[0], last = merge_heap[--merge_heap_size];
+        int parent = 0;
+        while (true)
+        {
+            int child = 2 * parent + 1;
+            if (child >= merge_heap_size)
+                break;
+            if (child + 1 < merge_heap_size && MergeHeadFirst(merge_heap[child + 1], merge_heap[child]))
+                child++;
+            if (!MergeHeadFirst(merge_heap[child], last))
+                break;
+            merge_heap[parent] = merge_heap[child];
+            parent = child;
+        }
+        merge_heap[parent] = last;
+        return first;
+    }
+
+    // Merge a page of results from every stage, from the ordinals each stage has reached, and move the
+    // ordinals past them. Forwards, the page is read into the results if read is set; backwards, the
+    // ordinals move back to the start of the page before.
+    void MergePage(int ordinals[], const bool backwards, const bool read)
+    {
+        merge_backwards = backwards;
+        merge_heap_size = 0;
+        for (int i = 0; i < STAGES_COUNT; i++)
+            if (backwards ? ordinals[i] > stage_first_ordinals[i]
+                          : ordinals[i] < stage_first_ordinals[i] + stage_result_counts[i])
+                PushMergeHead(i, backwards ? ordinals[i] - 1 : ordinals[i]);
+        for (int r = 0; r < MAX_SEARCH_RESULTS_PER_PAGE; r++)
+        {
+            if (merge_heap_size == 0)
+            {
+                if (read)
+                    results[r].file_pos = -1;
+                continue;
+            }
+            const int i = PopMergeHead();
+            if (read)
+            {
+                results[r].file_pos = merge_heads[i].file_pos;
+                results[r].stage = STAGES[i];
+                charset::CopyString(merge_heads[i].title, results[r].title,
+                                    SearchResult::MAX_DISPLAY_METHOD_TITLE_CHARS,
+                                    SearchResult::MAX_DISPLAY_METHOD_TITLE_BYTES, true);
+            }
+            if (backwards ? --ordinals[i] > stage_first_ordinals[i]
+                          : ++ordinals[i] < stage_first_ordinals[i] + stage_result_counts[i])
+                PushMergeHead(i, backwards ? ordinals[i] - 1 : ordinals[i]);
+        }
+    }
+
+    // Step the merge from the page it has reached to the selected page, and read that page.
+    bool ReadMergedPageEntries()
+    {
+        if (selected_page == 0) // starts at the first result of every stage
+        {
+            for (int i = 0; i < STAGES_COUNT; i++)
+                merge_page_ordinals[i] = stage_first_ordinals[i];
+            merge_page = 0;
+        }
+        for (; merge_page < selected_page; merge_page++)
+            MergePage(merge_page_ordinals, false, false);
+        for (; merge_page > selected_page; merge_page--)
+            MergePage(merge_page_ordinals, true, false);
+        int ordinals[STAGES_COUNT];
+        for (int i = 0; i < STAGES_COUNT; i++)
+            ordinals[i] = merge_page_ordinals[i];
+        MergePage(ordinals, false, true);
+        return (selected_page + 1) * MAX_SEARCH_RESULTS_PER_PAGE >= result_count;
+    }
+
+    // Find the results on every stage, within those already found if narrow, and read the first page.
+    bool SearchAllStages(const bool narrow)
+    {
+        for (int i = 0; i < STAGES_COUNT; i++)
+        {
+            if (narrow && stage_result_counts[i] == 0)
+                continue;
+            if (!mf->SelectStage(STAGES[i]) || !mf->HasIndex())
+            {
+                stage_result_counts[i] = 0;
+                continue;
+            }
+            if (narrow ? !mf->NarrowOrdinals(search_text, stage_first_ordinals[i], stage_result_counts[i])
+                       : !mf->SearchOrdinals(search_text, stage_first_ordinals[i], stage_result_counts[i]))
+                return false;
+        }
+        for (int i = 0; i < STAGES_COUNT; i++)
+            result_count += stage_result_counts[i];
+        search_pages = OrdinalPageCount();
+        ReadPageEntries();
+        return true;
+    }
+
+    int OrdinalPageCount() const
+    {
+        if (result_count <= 0)
+            return 1;
+        return (result_count + MAX_SEARCH_RESULTS_PER_PAGE - 1) / MAX_SEARCH_RESULTS_PER_PAGE;
+    }
+
+    void ResetPages()
     {
         search_pages = MAX_SEARCH_PAGES; // (make a guess - can be refined)
         selected_page = 0;
         selected_result = 0;
         for (int page = 0; page < MAX_SEARCH_PAGES + 1; page++)
             file_page_positions[page] = 0;
+        results_end = -1;
+        first_ordinal = 0;
+        result_count = 0;
+    }
+
+    bool Search()
+    {
+        ResetPages();
+        if (search_mode == SearchMode::AllStages)
+            return SearchAllStages(false);
+        if (search_mode == SearchMode::Fuzzy)
+        {
+            if (!mf->SearchFuzzy(search_text, FuzzyDistance(search_cursor), fuzzy_ordinals, fuzzy_distances,
+                                 MAX_FUZZY_RESULTS, result_count))
+                return false;
+            search_pages = OrdinalPageCount();
+            ReadPageEntries();
+            return true;
+        }
+        if (search_mode == SearchMode::Infix) // from the first ordinal, which ResetPages leaves as the first page
+        {
+            if (ReadPageEntries())
+                search_pages = 1;
+            return true;
+        }
+        if (ordinal_search)
+        {
+            if (!mf->SearchOrdinals(search_text, first_ordinal, result_count))
+                return false;
+            search_pages = OrdinalPageCount();
+            ReadPageEntries();
+            return true;
+        }
         if (!mf->Search(search_text, &file_page_positions[0]))
             return false;
         if (ReadPageEntries())
@@ -200,6 +524,135 @@ class SearchScreen
         return true;
     }
 
+    // Search for search_text, which has just been extended: its results lie within those of the shorter search.
+    bool RefineSearch()
+    {
+        if (search_mode == SearchMode::Fuzzy) // the closest results may all change
+            return Search();
+        if (search_mode == SearchMode::AllStages)
+        {
+            ResetPages();
+            return SearchAllStages(true);
+        }
+        if (search_mode == SearchMode::Infix)
+        {
+            const int start = file_page_positions[0];
+            ResetPages();
+            file_page_positions[0] = start;
+            if (ReadPageEntries())
+                search_pages = 1;
+            return true;
+        }
+        if (ordinal_search)
+        {
+            int first = first_ordinal, count = result_count;
+            ResetPages();
+            if (!mf->NarrowOrdinals(search_text, first, count))
+                return false;
+            first_ordinal = first;
+            result_count = count;
+            search_pages = OrdinalPageCount();
+            ReadPageEntries();
+            return true;
+        }
+
+        // scan from the start of the previous results up to their end (or -1 if not yet found)
+        const int start = file_page_positions[0], end = results_end;
+        ResetPages();
+        charset::NonMBChar search_key[MAX_SEARCH_LENGTH + 1];
+        charset::NormaliseSearch(search_text, search_key, MAX_SEARCH_LENGTH);
+        charset::MBChar title[ringing::MAX_METHOD_TITLE_LENGTH];
+        mf->Seek(start);
+        for (int i = 0; i < MAX_REFINE_SCAN; i++)
+        {
+            const int pos = mf->Tell();
+            if (mf->EndOfFile() || (end >= 0 && pos >= end)) // no results
+            {
+                file_page_positions[0] = pos;
+                goto found;
+            }
+            if (!mf->ReadMethodSummary(nullptr, nullptr, title))
+                return false;
+            if (charset::CompareNormalisedSearch(search_key, title) != charset::CompareResult::BeforeKey)
+            {
+                file_page_positions[0] = pos;
+                goto found;
+            }
+        }
+        return Search(); // too far to scan
+
+    found:
+        if (ReadPageEntries())
+            search_pages = 1;
+        return true;
+    }
+
+    void SaveLevel()
+    {
+        SearchLevel &level = levels[search_cursor];
+        for (int page = 0; page < MAX_SEARCH_PAGES + 1; page++)
+            level.file_page_positions[page] = file_page_positions[page];
+        level.search_pages = search_pages;
+        level.results_end = results_end;
+        level.first_ordinal = first_ordinal;
+        level.result_count = result_count;
+        level.saved = true;
+    }
+
+    void ForgetLevels()
+    {
+        for (int cursor = 0; cursor < MAX_SEARCH_LENGTH; cursor++)
+            levels[cursor].saved = false;
+    }
+
+    // Return to the search for a shorter prefix, saved before it was extended.
+    bool RestoreLevel()
+    {
+        const SearchLevel &level = levels[search_cursor];
+        // the results of every stage aren't saved, so are found again
+        if (!level.saved || search_mode == SearchMode::Fuzzy || search_mode == SearchMode::AllStages)
+            return Search();
+        for (int page = 0; page < MAX_SEARCH_PAGES + 1; page++)
+            file_page_positions[page] = level.file_page_positions[page];
+        search_pages = level.search_pages;
+        results_end = level.results_end;
+        first_ordinal = level.first_ordinal;
+        result_count = level.result_count;
+        ShowFirstPage();
+        return true;
+    }
+
+    void ShowFirstPage()
+    {
+        selected_page = 0;
+        selected_result = 0;
+        ReadPageEntries();
+    }
+
+    // Edits allowed in a fuzzy search: none in a few characters, which would match almost anything.
+    static int FuzzyDistance(const int length)
+    {
+        if (length < 3)
+            return 0;
+        return length < 7 ? 1 : 2;
+    }
+
+    // Switch to a search mode, or back to prefix search if it is already in it.
+    bool SwitchMode(const SearchMode mode)
+    {
+        if (!good_read || !ordinal_search)
+            return true;
+        if (mode == SearchMode::AllStages && !mf->IsLibrary()) // only a library holds every stage
+            return true;
+        search_mode = search_mode == mode ? SearchMode::Prefix : mode;
+        ForgetLevels();
+        // searching every stage leaves the reader on any of them
+        if (search_mode != SearchMode::AllStages && mf->GetStage() != STAGES[cur_stage_index] &&
+            !LoadMethodFile(*mf, STAGES[cur_stage_index]))
+            return false;
+        return Search();
+    }
+
     void GoToPage(int index)
     {
         if (index < 0)
@@ -212,6 +665,13 @@ class SearchScreen
             index = search_pages - 1;
             selected_result = MAX_SEARCH_RESULTS_PER_PAGE - 1;
         }
+        // any page can be read directly
+        if (ordinal_search && search_mode != SearchMode::Infix)
+        {
+            selected_page = index;
+            ReadPageEntries();
+            return;
+        }
         for (selected_page = 0; selected_page < index; selected_page++)
         {
             if (file_page_positions[selected_page + 1] == 0)
@@ -229,7 +689,7 @@ class SearchScreen
         if (ReadPageEntries())
         {
         last_page:
-            if (!results[0].Exists()) // this page is empty
+            if (!results[0].Exists() && selected_page > 0) // this page is empty
             {
                 selected_page--;
                 selected_result = MAX_SEARCH_RESULTS_PER_PAGE - 1;
@@ -243,6 +703,9 @@ public:
     void Initialise()
     {
         good_read = false;
+        ordinal_search = false;
+        search_mode = SearchMode::Prefix;
+        ForgetLevels();
         new_stage_index = INITIAL_STAGE_INDEX;
     }
 
@@ -264,11 +727,15 @@ public:
         EnableDisplayHeader(2, 1); // Let GetKey draw status area
     }
 
+    // Position of the selected method, moving the reader to its stage if it was found on every stage.
     int GetSelectedFilePos()
     {
         if (!good_read)
             return -1;
-        return results[selected_result].file_pos;
+        const SearchResult &result = results[selected_result];
+        if (search_mode == SearchMode::AllStages && result.Exists() && !mf->SelectStage(result.stage))
+            return -1;
+        return result.file_pos;
     }
 
     void SetFileReader(ringing::FileReader *mf)
@@ -293,6 +760,8 @@ public:
         switch (key)
         {
         case KEY_SHIFT_LEFT:
+            if (search_mode == SearchMode::AllStages)
+                goto switch_all_stages; // back to the stage searched before
             if (cur_stage_index == 0) // no change
                 break;
             new_stage_index = cur_stage_index - 1;
@@ -300,6 +769,8 @@ public:
                 new_stage_index = 0;
             return ScreenState::ReloadSearch;
         case KEY_SHIFT_RIGHT:
+            if (search_mode == SearchMode::AllStages)
+                goto switch_all_stages;
             if (cur_stage_index == STAGES_COUNT - 1) // no change
                 break;
             new_stage_index = cur_stage_index + 1;
@@ -309,12 +780,40 @@ public:
 
         case KEY_CTRL_DEL:
             if (search_cursor > 0)
+            {
                 search_text[--search_cursor] = 0;
-            goto research;
+                if (!RestoreLevel())
+                    return ScreenState::MethodReadError;
+            }
+            else
+                ShowFirstPage();
+            SetInputMode(KEYBOARD_MODE_ALPHA_LOCK);
+            break;
         case KEY_CTRL_AC:
-            search_text[search_cursor = 0] = 0;
-        research:
-            if (!Search())
+            if (search_cursor > 0)
+            {
+                search_text[search_cursor = 0] = 0;
+                if (!RestoreLevel())
+                    return ScreenState::MethodReadError;
+            }
+            else
+                ShowFirstPage();
+            SetInputMode(KEYBOARD_MODE_ALPHA_LOCK);
+            break;
+
+        case KEY_CTRL_F1: // switch between matching the start of titles and anywhere in them
+            if (!SwitchMode(SearchMode::Infix))
+                return ScreenState::MethodReadError;
+            SetInputMode(KEYBOARD_MODE_ALPHA_LOCK);
+            break;
+        case KEY_CTRL_F2: // switch between matching the start of titles exactly and with typos
+            if (!SwitchMode(SearchMode::Fuzzy))
+                return ScreenState::MethodReadError;
+            SetInputMode(KEYBOARD_MODE_ALPHA_LOCK);
+            break;
+        case KEY_CTRL_F3: // switch between searching one stage and every stage
+        switch_all_stages:
+            if (!SwitchMode(SearchMode::AllStages))
                 return ScreenState::MethodReadError;
             SetInputMode(KEYBOARD_MODE_ALPHA_LOCK);
             break;
@@ -362,14 +861,12 @@ public:
         default:
         {
             charset::NonMBChar c;
-            if (KeyToChar(key, &c))
+            if (KeyToChar(key, &c) && search_cursor < MAX_SEARCH_LENGTH)
             {
-                if (search_cursor < MAX_SEARCH_LENGTH)
-                {
-                    search_text[search_cursor++] = c;
-                    search_text[search_cursor] = 0;
-                }
-                if (!Search())
+                SaveLevel();
+                search_text[search_cursor++] = c;
+                search_text[search_cursor] = 0;
+                if (!RefineSearch())
                     return ScreenState::MethodReadError;
             }
             break;
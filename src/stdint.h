@@ -14,6 +14,12 @@ extern "C"
     static_assert(sizeof(uint16_t) == 2, "uint16_t should be 2 bytes");
     typedef unsigned int uint32_t;
     static_assert(sizeof(uint32_t) == 4, "uint32_t should be 4 bytes");
+#ifdef __UINT64_TYPE__
+    typedef __UINT64_TYPE__ uint64_t;
+#else
+    typedef unsigned long long uint64_t;
+#endif
+    static_assert(sizeof(uint64_t) == 8, "uint64_t should be 8 bytes");
 
 #ifdef __cplusplus
 }